@@ -0,0 +1,210 @@
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <cstddef>
+#include "binary_matrix.hpp"
+
+// Batch versions of the SmallBinaryMatrix primitives. Every kernel is branch-free on the packed
+// 64-bit word (row i in byte i), so the same code runs on one word or on 4/8 words of an
+// AVX2/AVX-512 register. The widest instruction set of the running CPU is picked at runtime.
+
+#define BATCH_INLINE __attribute__((always_inline)) inline
+#define BATCH_LAMBDA __attribute__((always_inline))
+
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint64_t u64x8 __attribute__((vector_size(64)));
+
+constexpr uint64_t BYTE_LOW_BITS = 0x0101010101010101ULL;
+
+// The word kernels work in place on a reference: a vector type is never passed or returned by
+// value outside the target-specific functions.
+
+template<typename V>
+BATCH_INLINE void _transpose_word(V& x) {
+    V t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;  x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL; x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL; x ^= t ^ (t << 28);
+}
+
+template<typename V>
+BATCH_INLINE void _broadcast_byte(V& row) { // row holds a single nonzero byte
+    row |= row >> 8; row |= row >> 16; row |= row >> 32;
+    row |= row << 8; row |= row << 16; row |= row << 32;
+}
+
+// Gauss-Jordan elimination; x becomes 1 in singular lanes. The pivot of column c is the lowest
+// unused row with a one there, it is xor-ed into every other row with a one in column c.
+template<uint32_t N, typename V>
+BATCH_INLINE void _singular_word(V& x) {
+    constexpr uint64_t rows = BYTE_LOW_BITS >> (8 * (8 - N));
+    V used = x ^ x, res = x ^ x;
+    for(uint32_t c = 0; c < N; c++){
+        V col = (x >> c) & rows;
+        V p = col & ~used;
+        p &= -p;
+        res |= (p - 1) >> 63;
+        V pivot_row = x & ((p << 8) - p);
+        _broadcast_byte(pivot_row);
+        V targets = col & ~p;
+        x ^= ((targets << 8) - targets) & pivot_row; // bit 0 of a byte -> whole byte
+        used |= p;
+    }
+    x = res;
+}
+
+// x becomes 1 in the lanes whose leading (TRAILING: trailing) principal minors are all nonsingular
+template<uint32_t N, bool TRAILING, typename V>
+BATCH_INLINE void _principal_minors_word(V& x) {
+    V res = (x ^ x) + 1;
+    for(uint32_t k = 0; k < N; k++){
+        uint32_t i = TRAILING ? N - 1 - k : k;
+        // rows still to be eliminated: below the pivot, or above it for trailing minors
+        const uint64_t rest = TRAILING ? (i ? BYTE_LOW_BITS >> (8 * (8 - i)) : 0ULL)
+                                       : (BYTE_LOW_BITS >> (8 * (8 - N))) & ~(BYTE_LOW_BITS >> (8 * (7 - i)));
+        res &= x >> (9 * i);
+        V row = (x >> (8 * i)) & 0xFF;
+        row |= row << 8; row |= row << 16; row |= row << 32;
+        V targets = (x >> i) & rest;
+        x ^= ((targets << 8) - targets) & row;
+    }
+    x = res & 1;
+}
+
+template<uint32_t N, typename V>
+BATCH_INLINE void _product_word(V& a, const V& b) {
+    V bt = b, res = a ^ a;
+    _transpose_word(bt);
+    for(uint32_t j = 0; j < N; j++){
+        V col = (bt >> (8 * j)) & 0xFF;
+        col |= col << 8; col |= col << 16; col |= col << 32;
+        V t = a & col;
+        t ^= t >> 4; t ^= t >> 2; t ^= t >> 1;
+        res |= (t & (BYTE_LOW_BITS >> (8 * (8 - N)))) << j;
+    }
+    a = res;
+}
+
+// LU_decomposition of a lane with nonsingular leading minors, packed in one word: L below the
+// diagonal (its unit diagonal left out), U on and above it
+template<uint32_t N, typename V>
+BATCH_INLINE void _LU_word(V& x) {
+    V l = x ^ x;
+    for(uint32_t i = 0; i < N; i++){
+        const uint64_t below = (BYTE_LOW_BITS >> (8 * (8 - N))) & ~(BYTE_LOW_BITS >> (8 * (7 - i)));
+        V row = (x >> (8 * i)) & 0xFF;
+        row |= row << 8; row |= row << 16; row |= row << 32;
+        V targets = (x >> i) & below;
+        l |= targets << i;
+        x ^= ((targets << 8) - targets) & row;
+    }
+    x ^= l;
+}
+
+enum class simd_level { scalar, avx2, avx512 };
+
+inline simd_level detect_simd_level() {
+    static const simd_level level = []() {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f")) return simd_level::avx512;
+        if(__builtin_cpu_supports("avx2")) return simd_level::avx2;
+        return simd_level::scalar;
+    }();
+    return level;
+}
+
+// Applies kernel(a, b) to n packed matrices, L lanes at a time; the tail runs on single words.
+template<typename V, uint32_t L, typename F>
+BATCH_INLINE void _batch_apply(const uint64_t* in1, const uint64_t* in2, uint64_t* out, size_t n, F kernel) {
+    size_t i = 0;
+    for(; i + L <= n; i += L){
+        V a, b;
+        std::memcpy(&a, in1 + i, sizeof(V));
+        b = a;
+        if(in2) std::memcpy(&b, in2 + i, sizeof(V));
+        kernel(a, b);
+        std::memcpy(out + i, &a, sizeof(V));
+    }
+    for(; i < n; i++){
+        uint64_t a = in1[i], b = in2 ? in2[i] : a;
+        kernel(a, b);
+        out[i] = a;
+    }
+}
+
+template<typename F>
+__attribute__((target("avx512f"))) void _batch_avx512(const uint64_t* in1, const uint64_t* in2, uint64_t* out, size_t n, F kernel) {
+    _batch_apply<u64x8, 8>(in1, in2, out, n, kernel);
+}
+
+template<typename F>
+__attribute__((target("avx2"))) void _batch_avx2(const uint64_t* in1, const uint64_t* in2, uint64_t* out, size_t n, F kernel) {
+    _batch_apply<u64x4, 4>(in1, in2, out, n, kernel);
+}
+
+template<typename F>
+void _batch_scalar(const uint64_t* in1, const uint64_t* in2, uint64_t* out, size_t n, F kernel) {
+    _batch_apply<uint64_t, 1>(in1, in2, out, n, kernel);
+}
+
+// The kernels are passed as generic lambdas so each target instantiates them with its own lanes.
+template<typename F>
+void _batch_dispatch(const uint64_t* in1, const uint64_t* in2, uint64_t* out, size_t n, F kernel) {
+    switch(detect_simd_level()){
+        case simd_level::avx512: _batch_avx512(in1, in2, out, n, kernel); break;
+        case simd_level::avx2: _batch_avx2(in1, in2, out, n, kernel); break;
+        default: _batch_scalar(in1, in2, out, n, kernel);
+    }
+}
+
+template<uint32_t N>
+const uint64_t* _words(const SmallBinaryMatrix<N>* m) {
+    static_assert(sizeof(SmallBinaryMatrix<N>) == sizeof(uint64_t));
+    return reinterpret_cast<const uint64_t*>(m);
+}
+
+template<uint32_t N>
+void batch_transpose(const SmallBinaryMatrix<N>* in, SmallBinaryMatrix<N>* out, size_t n) {
+    _batch_dispatch(_words(in), nullptr, reinterpret_cast<uint64_t*>(out), n, [](auto& x, const auto&) BATCH_LAMBDA { _transpose_word(x); });
+}
+
+template<uint32_t N>
+void batch_product(const SmallBinaryMatrix<N>* a, const SmallBinaryMatrix<N>* b, SmallBinaryMatrix<N>* out, size_t n) {
+    _batch_dispatch(_words(a), _words(b), reinterpret_cast<uint64_t*>(out), n, [](auto& x, const auto& y) BATCH_LAMBDA { _product_word<N>(x, y); });
+}
+
+// out[i] = 1 if in[i] is singular
+template<uint32_t N>
+void batch_singular(const SmallBinaryMatrix<N>* in, uint64_t* out, size_t n) {
+    _batch_dispatch(_words(in), nullptr, out, n, [](auto& x, const auto&) BATCH_LAMBDA { _singular_word<N>(x); });
+}
+
+// out[i] = 1 if all leading principal minors of in[i] are nonsingular
+template<uint32_t N>
+void batch_main_minors_non_singular(const SmallBinaryMatrix<N>* in, uint64_t* out, size_t n) {
+    _batch_dispatch(_words(in), nullptr, out, n, [](auto& x, const auto&) BATCH_LAMBDA { _principal_minors_word<N, false>(x); });
+}
+
+// out[i] = 1 if all trailing principal minors of in[i] are nonsingular (anti_minors_non_singular)
+template<uint32_t N>
+void batch_anti_minors_non_singular(const SmallBinaryMatrix<N>* in, uint64_t* out, size_t n) {
+    _batch_dispatch(_words(in), nullptr, out, n, [](auto& x, const auto&) BATCH_LAMBDA { _principal_minors_word<N, true>(x); });
+}
+
+// LU_decomposition of every in[i] into (L[i], U[i]); in[i] must have nonsingular leading minors
+// (batch_main_minors_non_singular), other lanes get unspecified factors. U may alias in.
+template<uint32_t N>
+void batch_LU_decomposition(const SmallBinaryMatrix<N>* in, SmallBinaryMatrix<N>* L, SmallBinaryMatrix<N>* U, size_t n) {
+    constexpr uint64_t diag = 0x8040201008040201ULL >> (9 * (8 - N));
+    constexpr uint64_t upper = []() {
+        uint64_t res = 0;
+        for(uint32_t i = 0; i < N; i++) for(uint32_t j = i; j < N; j++) res |= 1ULL << (8 * i + j);
+        return res;
+    }();
+    uint64_t* u = reinterpret_cast<uint64_t*>(U);
+    _batch_dispatch(_words(in), nullptr, u, n, [](auto& x, const auto&) BATCH_LAMBDA { _LU_word<N>(x); });
+    for(size_t i = 0; i < n; i++){
+        L[i] = SmallBinaryMatrix<N>((u[i] & ~upper) | diag);
+        U[i] = SmallBinaryMatrix<N>(u[i] & upper);
+    }
+}
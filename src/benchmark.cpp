@@ -0,0 +1,313 @@
+#include "binary_matrix.hpp"
+#include "wide_binary_matrix.hpp"
+#include "matrix_operations.hpp"
+#include "utils.hpp"
+#include "compare.hpp"
+#include "matrix_permutations.hpp"
+#include "batch_kernels.hpp"
+#include "four_russians.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include <stdint.h>
+
+// Every benchmark cycles through a fixed set of random matrices, one matrix per iteration, so the
+// reported time is ns/op. The seed depends only on N, runs are comparable between builds.
+constexpr uint32_t SAMPLES = 1024;
+
+template<uint32_t N>
+const std::vector<SmallBinaryMatrix<N>>& samples() {
+    static const std::vector<SmallBinaryMatrix<N>> res = []() {
+        std::mt19937_64 rng(0x5eed0000 + N);
+        std::vector<SmallBinaryMatrix<N>> res;
+        for(uint32_t i = 0; i < SAMPLES; i++) res.emplace_back(rng());
+        return res;
+    }();
+    return res;
+}
+
+// pairs (m1, m2) where m2 has the ones of m1 and a few more, so check_prec does not stop at the
+// entry count
+template<uint32_t N>
+const std::vector<std::pair<SmallBinaryMatrix<N>, SmallBinaryMatrix<N>>>& sample_pairs() {
+    static const std::vector<std::pair<SmallBinaryMatrix<N>, SmallBinaryMatrix<N>>> res = []() {
+        std::mt19937_64 rng(0x5eed1000 + N);
+        std::vector<std::pair<SmallBinaryMatrix<N>, SmallBinaryMatrix<N>>> res;
+        for(uint32_t i = 0; i < SAMPLES; i++){
+            uint64_t m1 = rng() & rng();
+            res.emplace_back(SmallBinaryMatrix<N>(m1), SmallBinaryMatrix<N>(m1 | (rng() & rng() & rng())));
+        }
+        return res;
+    }();
+    return res;
+}
+
+template<uint32_t N>
+const std::vector<BinaryMatrix<N>>& wide_samples() {
+    static const std::vector<BinaryMatrix<N>> res = []() {
+        std::mt19937_64 rng(0x5eed2000 + N);
+        std::vector<BinaryMatrix<N>> res;
+        for(uint32_t i = 0; i < SAMPLES; i++){
+            typename BinaryMatrix<N>::row_t rows[N];
+            for(auto& r : rows) r = rng();
+            res.emplace_back(rows);
+        }
+        return res;
+    }();
+    return res;
+}
+
+// samples with nonsingular leading minors (LU_decomposition), or nonsingular ones for BinaryMatrix
+template<uint32_t N>
+const std::vector<SmallBinaryMatrix<N>>& lu_samples() {
+    static const std::vector<SmallBinaryMatrix<N>> res = []() {
+        std::mt19937_64 rng(0x5eed3000 + N);
+        std::vector<SmallBinaryMatrix<N>> res;
+        while(res.size() < SAMPLES){
+            SmallBinaryMatrix<N> m(rng());
+            if(m.main_minors_non_singular()) res.push_back(m);
+        }
+        return res;
+    }();
+    return res;
+}
+
+template<uint32_t N>
+const std::vector<BinaryMatrix<N>>& wide_nonsingular_samples() {
+    static const std::vector<BinaryMatrix<N>> res = []() {
+        std::vector<BinaryMatrix<N>> res;
+        for(const auto& m : wide_samples<N>()) if(!m.singular()) res.push_back(m);
+        return res;
+    }();
+    return res;
+}
+
+void set_counters(benchmark::State& state, size_t matrices) {
+    state.counters["matrices/s"] = benchmark::Counter(matrices, benchmark::Counter::kIsRate);
+}
+
+template<uint32_t N>
+void bm_transpose(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        SmallBinaryMatrix<N> m = ms[i++ % SAMPLES];
+        m.transpose();
+        benchmark::DoNotOptimize(m);
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_sub_matrix(benchmark::State& state) { // minors of size N - 1
+    const auto& ms = samples<N>();
+    constexpr auto masks = subset_mask<N, N - 1>;
+    uint32_t i = 0;
+    for(auto _ : state){
+        SmallBinaryMatrix<N> m = ms[i % SAMPLES];
+        auto sub = m.template sub_matrix<N - 1>(masks[i % N], masks[(i / N) % N]);
+        benchmark::DoNotOptimize(sub);
+        i++;
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_singular(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(ms[i++ % SAMPLES].singular());
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_batch_singular(benchmark::State& state) { // one iteration is the whole sample set
+    const auto& ms = samples<N>();
+    std::vector<uint64_t> out(SAMPLES);
+    for(auto _ : state){
+        batch_singular(ms.data(), out.data(), SAMPLES);
+        benchmark::DoNotOptimize(out.data());
+    }
+    set_counters(state, state.iterations() * SAMPLES);
+}
+
+template<uint32_t N>
+void bm_main_minors_non_singular(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(ms[i++ % SAMPLES].main_minors_non_singular());
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_normal_form(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(get_normal_form(ms[i++ % SAMPLES]));
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_permutation_data(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        auto data = get_permutation_data(ms[i++ % SAMPLES]);
+        benchmark::DoNotOptimize(data.permutations.data());
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_check_prec1(benchmark::State& state) {
+    const auto& ps = sample_pairs<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        auto [m1, m2] = ps[i++ % SAMPLES];
+        benchmark::DoNotOptimize(check_prec1(m1, m2));
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_check_prec2(benchmark::State& state) {
+    const auto& ps = sample_pairs<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        auto [m1, m2] = ps[i++ % SAMPLES];
+        benchmark::DoNotOptimize(check_prec2(m1, m2));
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_wide_transpose(benchmark::State& state) {
+    const auto& ms = wide_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        BinaryMatrix<N> m = ms[i++ % SAMPLES];
+        m.transpose();
+        benchmark::DoNotOptimize(m);
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_wide_singular(benchmark::State& state) {
+    const auto& ms = wide_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(ms[i++ % SAMPLES].singular());
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_wide_normal_form(benchmark::State& state) {
+    const auto& ms = wide_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(get_normal_form(ms[i++ % SAMPLES]));
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_product(benchmark::State& state) {
+    const auto& ms = samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(ms[i % SAMPLES] * ms[(i + 1) % SAMPLES]);
+        i++;
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_LU_decomposition(benchmark::State& state) {
+    const auto& ms = lu_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(LU_decomposition(ms[i++ % SAMPLES]));
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_batch_LU_decomposition(benchmark::State& state) { // one iteration is the whole sample set
+    const auto& ms = lu_samples<N>();
+    std::vector<SmallBinaryMatrix<N>> L(SAMPLES), U(SAMPLES);
+    for(auto _ : state){
+        batch_LU_decomposition(ms.data(), L.data(), U.data(), SAMPLES);
+        benchmark::DoNotOptimize(U.data());
+    }
+    set_counters(state, state.iterations() * SAMPLES);
+}
+
+#define BENCHMARK_ALL_N(f) \
+    BENCHMARK_TEMPLATE(f, 3); BENCHMARK_TEMPLATE(f, 4); BENCHMARK_TEMPLATE(f, 5); \
+    BENCHMARK_TEMPLATE(f, 6); BENCHMARK_TEMPLATE(f, 7); BENCHMARK_TEMPLATE(f, 8)
+
+// the check_prec searches over all N! x N! reorderings take seconds per matrix from N = 7 on; a
+// fixed number of iterations keeps those runs short and on the same samples
+#define BENCHMARK_ALL_N_SEARCH(f) \
+    BENCHMARK_TEMPLATE(f, 3); BENCHMARK_TEMPLATE(f, 4); BENCHMARK_TEMPLATE(f, 5); \
+    BENCHMARK_TEMPLATE(f, 6); BENCHMARK_TEMPLATE(f, 7)->Iterations(8); BENCHMARK_TEMPLATE(f, 8)->Iterations(1)
+
+BENCHMARK_ALL_N(bm_transpose);
+BENCHMARK_ALL_N(bm_sub_matrix);
+BENCHMARK_ALL_N(bm_singular);
+BENCHMARK_ALL_N(bm_batch_singular);
+BENCHMARK_ALL_N(bm_main_minors_non_singular);
+BENCHMARK_ALL_N(bm_normal_form);
+BENCHMARK_ALL_N(bm_permutation_data);
+BENCHMARK_ALL_N(bm_product);
+BENCHMARK_ALL_N(bm_LU_decomposition);
+BENCHMARK_ALL_N(bm_batch_LU_decomposition);
+BENCHMARK_ALL_N_SEARCH(bm_check_prec1);
+BENCHMARK_ALL_N_SEARCH(bm_check_prec2);
+
+template<uint32_t N>
+void bm_wide_product(benchmark::State& state) {
+    const auto& ms = wide_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(ms[i % SAMPLES] * ms[(i + 1) % SAMPLES]);
+        i++;
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_m4rm_product(benchmark::State& state) {
+    const auto& ms = wide_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(m4rm_product(ms[i % SAMPLES], ms[(i + 1) % SAMPLES]));
+        i++;
+    }
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_wide_reorder_LU(benchmark::State& state) { // the factors of plu_decomposition, one column at a time
+    const auto& ms = wide_nonsingular_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(LU_decomposition(reorder_principal_minors_non_singular(ms[i++ % ms.size()])));
+    set_counters(state, state.iterations());
+}
+
+template<uint32_t N>
+void bm_plu_decomposition(benchmark::State& state) {
+    const auto& ms = wide_nonsingular_samples<N>();
+    uint32_t i = 0;
+    for(auto _ : state) benchmark::DoNotOptimize(plu_decomposition(ms[i++ % ms.size()]));
+    set_counters(state, state.iterations());
+}
+
+#define BENCHMARK_WIDE_N(f) \
+    BENCHMARK_TEMPLATE(f, 8); BENCHMARK_TEMPLATE(f, 16); BENCHMARK_TEMPLATE(f, 32); BENCHMARK_TEMPLATE(f, 64)
+
+BENCHMARK_WIDE_N(bm_wide_transpose);
+BENCHMARK_WIDE_N(bm_wide_singular);
+BENCHMARK_WIDE_N(bm_wide_normal_form);
+BENCHMARK_WIDE_N(bm_wide_product);
+BENCHMARK_WIDE_N(bm_m4rm_product);
+BENCHMARK_WIDE_N(bm_wide_reorder_LU);
+BENCHMARK_WIDE_N(bm_plu_decomposition);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,160 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <bit>
+#include "binary_matrix.hpp"
+#include "wide_binary_matrix.hpp"
+
+// Canonical labelling under row/column permutations.
+// The representative is the reordering with maximal get_data(). It is built greedily from the
+// most significant row down: every placed row splits the ordered column cells into ones/zeros,
+// and we only branch between rows that reach the same value under the current cells.
+// Rows are words of type R with column j in bit j (uint8_t for SmallBinaryMatrix).
+template<uint32_t N, typename R = uint8_t>
+class canonical_labelling{
+public:
+    canonical_labelling(const R* _rows, uint32_t _cnt) : cnt(_cnt) {
+        std::copy(_rows, _rows + cnt, rows);
+    }
+
+    // rows of the representative, the most significant one first
+    const R* run() {
+        uint32_t idx[N];
+        for(uint32_t i = 0; i < cnt; i++) idx[i] = i;
+        R cells[N] = { ones(N) };
+        found = false;
+        search(0, idx, cnt, cells, 1);
+        return best;
+    }
+
+private:
+    R rows[N], cur[N], best[N];
+    uint32_t cnt;
+    bool found;
+
+    static R ones(uint32_t k) { return k ? (R)((R)~(R)0 >> (8 * sizeof(R) - k)) : 0; } // the k lowest bits
+
+    // value of row r when the ones of every cell are packed to its top
+    static R cell_value(R r, const R* cells, uint32_t cell_cnt) {
+        R res = 0;
+        uint32_t pos = N;
+        for(uint32_t i = 0; i < cell_cnt; i++){
+            uint32_t k = std::popcount((R)(r & cells[i]));
+            if(k) res |= (R)(ones(k) << (pos - k));
+            pos -= std::popcount(cells[i]);
+        }
+        return res;
+    }
+
+    // r and s are swapped by a cell-preserving column permutation that fixes every other row,
+    // so both branches lead to the same representative
+    bool interchangeable(uint32_t r, uint32_t s, const uint32_t* idx, uint32_t idx_cnt, const R* cells, uint32_t cell_cnt) const {
+        R diff = rows[r] ^ rows[s];
+        for(uint32_t i = 0; i < idx_cnt; i++){
+            if(idx[i] == r || idx[i] == s) continue;
+            R x = rows[idx[i]];
+            for(uint32_t j = 0; j < cell_cnt; j++){
+                R d = diff & cells[j];
+                if((x & d) != 0 && (x & d) != d) return false;
+            }
+        }
+        return true;
+    }
+
+    int compare_prefix(uint32_t depth) const {
+        if(!found) return 1;
+        for(uint32_t i = 0; i < depth; i++){
+            if(cur[i] != best[i]) return cur[i] > best[i] ? 1 : -1;
+        }
+        return 0;
+    }
+
+    void search(uint32_t depth, const uint32_t* idx, uint32_t idx_cnt, const R* cells, uint32_t cell_cnt) {
+        int state = compare_prefix(depth);
+        if(state < 0) return;
+        if(depth == cnt){
+            if(state > 0 || !found) std::copy(cur, cur + cnt, best);
+            found = true;
+            return;
+        }
+
+        R val[N], max_val = 0;
+        for(uint32_t i = 0; i < idx_cnt; i++){
+            val[i] = cell_value(rows[idx[i]], cells, cell_cnt);
+            max_val = std::max(max_val, val[i]);
+        }
+        if(state == 0 && max_val < best[depth]) return;
+
+        if(cell_cnt == N){ // discrete columns: the remaining rows have fixed values
+            std::copy(val, val + idx_cnt, cur + depth);
+            std::sort(cur + depth, cur + cnt, std::greater<R>());
+            search(cnt, idx, 0, cells, cell_cnt);
+            return;
+        }
+
+        cur[depth] = max_val;
+        uint32_t tried[N];
+        uint32_t tried_cnt = 0;
+        for(uint32_t i = 0; i < idx_cnt; i++){
+            R r = rows[idx[i]];
+            if(val[i] != max_val) continue;
+            bool skip = false;
+            for(uint32_t j = 0; j < tried_cnt && !skip; j++){
+                skip = rows[tried[j]] == r || interchangeable(tried[j], idx[i], idx, idx_cnt, cells, cell_cnt);
+            }
+            if(skip) continue;
+            tried[tried_cnt++] = idx[i];
+
+            uint32_t next_idx[N], next_cnt = 0;
+            for(uint32_t j = 0; j < idx_cnt; j++) if(j != i) next_idx[next_cnt++] = idx[j];
+            R next_cells[N];
+            uint32_t next_cell_cnt = 0;
+            for(uint32_t j = 0; j < cell_cnt; j++){
+                if(cells[j] & r) next_cells[next_cell_cnt++] = cells[j] & r;
+                if(cells[j] & ~r) next_cells[next_cell_cnt++] = cells[j] & ~r;
+            }
+            search(depth + 1, next_idx, next_cnt, next_cells, next_cell_cnt);
+        }
+    }
+};
+
+template<uint32_t N>
+uint64_t canonical_data(SmallBinaryMatrix<N> m) {
+    uint8_t rows[N];
+    for(uint32_t i = 0; i < N; i++) rows[i] = m[i];
+    canonical_labelling<N> cl(rows, N);
+    const uint8_t* best = cl.run();
+    uint64_t res = 0;
+    for(uint32_t i = 0; i < N; i++) res |= (uint64_t)best[i] << ((N - 1 - i) * 8);
+    return res;
+}
+
+template<uint32_t N>
+SmallBinaryMatrix<N> canonical_form(SmallBinaryMatrix<N> m, bool with_transpose = false) {
+    uint64_t best = canonical_data(m);
+    if(with_transpose){
+        m.transpose();
+        best = std::max(best, canonical_data(m));
+    }
+    return SmallBinaryMatrix<N>(best);
+}
+
+template<uint32_t N>
+BinaryMatrix<N> canonical_rows(const BinaryMatrix<N>& m) {
+    canonical_labelling<N, typename BinaryMatrix<N>::row_t> cl(m.rows(), N);
+    auto best = cl.run();
+    typename BinaryMatrix<N>::row_t rows[N];
+    for(uint32_t i = 0; i < N; i++) rows[N - 1 - i] = best[i];
+    return BinaryMatrix<N>(rows);
+}
+
+// the maximal reordering in the order of BinaryMatrix::operator<, the last row most significant
+template<uint32_t N>
+BinaryMatrix<N> canonical_form(BinaryMatrix<N> m, bool with_transpose = false) {
+    BinaryMatrix<N> best = canonical_rows(m);
+    if(with_transpose){
+        m.transpose();
+        best = std::max(best, canonical_rows(m));
+    }
+    return best;
+}
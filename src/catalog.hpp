@@ -0,0 +1,208 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <cstdio>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "binary_matrix.hpp"
+#include "minor_table.hpp"
+
+// Binary catalog of matrices: a catalog_header, then count SmallBinaryMatrix words (get_data(),
+// row i in byte i), then optionally count minor masks of mask_words words each and count group ids.
+// Every section starts 8-byte aligned, so a mapped file is read in place.
+struct catalog_header{
+    uint32_t magic = MAGIC;
+    uint32_t version = 1;
+    uint32_t n = 0;
+    uint32_t flags = 0;
+    uint64_t count = 0;
+    uint32_t mask_words = 0; // words per minor mask, 0 without masks
+    uint32_t reserved = 0;
+
+    static constexpr uint32_t MAGIC = 0x54434d42; // "BMCT"
+    static constexpr uint32_t HAS_MASKS = 1, HAS_GROUPS = 2;
+};
+
+template<uint32_t N>
+constexpr uint32_t catalog_mask_words() { return (sub_matrix_cnt<N, N>() + 63) / 64; }
+
+// Writes ms (with group ids if groups is not empty, and with the minor masks of
+// minor_table::mask<N>() if with_masks). The file is written to path.tmp and renamed.
+template<uint32_t N>
+void write_catalog(const std::string& path, const std::vector<SmallBinaryMatrix<N>>& ms, const std::vector<uint32_t>& groups = {}, bool with_masks = false) {
+    if(!groups.empty() && groups.size() != ms.size()) throw std::invalid_argument("one group id per matrix is needed");
+    catalog_header header;
+    header.n = N;
+    header.count = ms.size();
+    if(with_masks) { header.flags |= catalog_header::HAS_MASKS; header.mask_words = catalog_mask_words<N>(); }
+    if(!groups.empty()) header.flags |= catalog_header::HAS_GROUPS;
+
+    const std::string tmp = path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "wb");
+    if(!f) throw std::runtime_error("cannot open " + tmp);
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1;
+    for(auto m : ms) {
+        uint64_t data = m.get_data();
+        ok &= std::fwrite(&data, sizeof(data), 1, f) == 1;
+    }
+    if(with_masks){
+        std::vector<uint64_t> words(header.mask_words);
+        for(auto m : ms) {
+            auto mask = minor_table<N>(m).template mask<N>();
+            std::fill(words.begin(), words.end(), 0);
+            for(size_t i = mask._Find_first(); i < mask.size(); i = mask._Find_next(i)) words[i / 64] |= 1ULL << (i % 64);
+            ok &= std::fwrite(words.data(), sizeof(uint64_t), words.size(), f) == words.size();
+        }
+    }
+    if(!groups.empty()){
+        ok &= std::fwrite(groups.data(), sizeof(uint32_t), groups.size(), f) == groups.size();
+        const uint32_t pad = 0;
+        if(groups.size() % 2) ok &= std::fwrite(&pad, sizeof(pad), 1, f) == 1;
+    }
+    ok &= std::fclose(f) == 0;
+    if(!ok || std::rename(tmp.c_str(), path.c_str()) != 0) throw std::runtime_error("cannot write catalog " + path);
+}
+
+// Header of a catalog file, to pick N before opening it as a catalog<N>.
+inline catalog_header read_catalog_header(const std::string& path) {
+    catalog_header header;
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if(!f) throw std::runtime_error("cannot open " + path);
+    bool ok = std::fread(&header, sizeof(header), 1, f) == 1;
+    std::fclose(f);
+    if(!ok || header.magic != catalog_header::MAGIC || header.version != 1) throw std::runtime_error("not a matrix catalog: " + path);
+    return header;
+}
+
+// Calls f(std::integral_constant<uint32_t, N>{}) for the runtime size n, to go from a catalog header
+// or a text file to the templates: catalog_dispatch(n, [&](auto size){ catalog<size()> c(path); ... }).
+template<typename F>
+void catalog_dispatch(uint32_t n, F&& f) {
+    switch(n){
+        case 1: f(std::integral_constant<uint32_t, 1>()); break;
+        case 2: f(std::integral_constant<uint32_t, 2>()); break;
+        case 3: f(std::integral_constant<uint32_t, 3>()); break;
+        case 4: f(std::integral_constant<uint32_t, 4>()); break;
+        case 5: f(std::integral_constant<uint32_t, 5>()); break;
+        case 6: f(std::integral_constant<uint32_t, 6>()); break;
+        case 7: f(std::integral_constant<uint32_t, 7>()); break;
+        case 8: f(std::integral_constant<uint32_t, 8>()); break;
+        default: throw std::runtime_error("unsupported matrix size " + std::to_string(n));
+    }
+}
+
+// Read-only memory-mapped catalog. The matrices are used in place, nothing is parsed or copied.
+template<uint32_t N>
+class catalog{
+public:
+    explicit catalog(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(catalog_header)) { close(fd); throw std::runtime_error("not a matrix catalog: " + path); }
+        length = st.st_size;
+        base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(base == MAP_FAILED) throw std::runtime_error("cannot map " + path);
+
+        const auto& h = header();
+        size_t expected = sizeof(catalog_header) + h.count * (sizeof(uint64_t) + h.mask_words * sizeof(uint64_t));
+        if(h.flags & catalog_header::HAS_GROUPS) expected += (h.count + 1) / 2 * sizeof(uint64_t);
+        if(h.magic != catalog_header::MAGIC || h.version != 1 || h.n != N || length != expected
+            || ((h.flags & catalog_header::HAS_MASKS) && h.mask_words != catalog_mask_words<N>())){
+            munmap(base, length);
+            throw std::runtime_error("not a catalog of " + std::to_string(N) + "x" + std::to_string(N) + " matrices: " + path);
+        }
+    }
+    ~catalog() { if(base) munmap(base, length); }
+
+    catalog(const catalog&) = delete;
+    catalog& operator=(const catalog&) = delete;
+    catalog(catalog&& c) : base(c.base), length(c.length) { c.base = nullptr; }
+
+    const catalog_header& header() const { return *static_cast<const catalog_header*>(base); }
+    size_t size() const { return header().count; }
+    bool has_masks() const { return header().flags & catalog_header::HAS_MASKS; }
+    bool has_groups() const { return header().flags & catalog_header::HAS_GROUPS; }
+
+    const SmallBinaryMatrix<N>* matrices() const {
+        static_assert(sizeof(SmallBinaryMatrix<N>) == sizeof(uint64_t));
+        return reinterpret_cast<const SmallBinaryMatrix<N>*>(words());
+    }
+    SmallBinaryMatrix<N> operator[](size_t i) const { return matrices()[i]; }
+    const SmallBinaryMatrix<N>* begin() const { return matrices(); }
+    const SmallBinaryMatrix<N>* end() const { return matrices() + size(); }
+
+    const uint64_t* mask_words(size_t i) const { return words() + size() + i * header().mask_words; } // needs has_masks()
+    minor_mask<N> mask(size_t i) const { // same layout as minor_table::mask<N>()
+        minor_mask<N> res;
+        const uint64_t* w = mask_words(i);
+        for(size_t j = 0; j < res.size(); j++) res[j] = (w[j / 64] >> (j % 64)) & 1;
+        return res;
+    }
+
+    uint32_t group(size_t i) const { // needs has_groups()
+        return reinterpret_cast<const uint32_t*>(words() + size() * (1 + header().mask_words))[i];
+    }
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+
+    const uint64_t* words() const { return reinterpret_cast<const uint64_t*>(static_cast<const char*>(base) + sizeof(catalog_header)); }
+};
+
+// Matrices of the text files in output/: N lines of N '0'/'1' characters each. Other lines are
+// labels; "idx: g", possibly indented, starts group g (out_minimal_groups*.txt,
+// out*_reduction_step.txt), and groups stays empty if there is none. n is set from the row length.
+inline void read_text_catalog(std::istream& in, uint32_t& n, std::vector<uint64_t>& ms, std::vector<uint32_t>& groups) {
+    n = 0;
+    ms.clear();
+    groups.clear();
+    bool grouped = false;
+    uint32_t group = 0, rows = 0;
+    uint64_t cur = 0;
+    std::string line;
+    while(std::getline(in, line)){
+        if(!line.empty() && line.back() == '\r') line.pop_back();
+        bool is_row = !line.empty() && line.find_first_not_of("01") == std::string::npos;
+        if(!is_row){
+            if(rows) throw std::runtime_error("incomplete matrix before: " + line);
+            const size_t start = line.find_first_not_of(" \t");
+            if(start != std::string::npos && line.compare(start, 4, "idx:") == 0) { grouped = true; group = std::stoul(line.substr(start + 4)); }
+            continue;
+        }
+        if(!n) n = line.size();
+        if(line.size() != n || n > 8) throw std::runtime_error("bad matrix row: " + line);
+        for(uint32_t j = 0; j < n; j++) if(line[j] == '1') cur |= 1ULL << (8 * rows + j);
+        if(++rows == n){
+            ms.push_back(cur);
+            if(grouped) groups.push_back(group);
+            cur = rows = 0;
+        }
+    }
+    if(rows) throw std::runtime_error("incomplete matrix at the end of the input");
+}
+
+// the layout of min_normal_forms*.txt, or of out_minimal_groups*.txt if groups are given. Only the
+// matrices and group ids are written: labels, trailers and step labels of the file the catalog was
+// made from are not in it.
+inline void write_text_catalog(std::ostream& out, uint32_t n, const std::vector<uint64_t>& ms, const std::vector<uint32_t>& groups = {}) {
+    for(size_t k = 0; k < ms.size(); k++){
+        if(groups.empty()) out << "id: " << k << '\n';
+        else if(k == 0 || groups[k] != groups[k - 1]) out << "=====================\nidx: " << groups[k] << '\n';
+        for(uint32_t i = 0; i < n; i++){
+            for(uint32_t j = 0; j < n; j++) out << ((ms[k] >> (8 * i + j)) & 1);
+            out << '\n';
+        }
+        if(!groups.empty()) out << '\n';
+    }
+}
@@ -0,0 +1,66 @@
+#include "catalog.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// catalog_convert to-binary <in.txt> <out.bin> [--masks]
+// catalog_convert to-text <in.bin> <out.txt>
+// A catalog keeps the matrices and their group ids only, so to-text does not restore the labels,
+// trailers and step labels of the original text file.
+
+template<uint32_t N>
+void to_binary(const std::string& path, const std::vector<uint64_t>& data, const std::vector<uint32_t>& groups, bool with_masks){
+    std::vector<SmallBinaryMatrix<N>> ms(data.begin(), data.end());
+    write_catalog<N>(path, ms, groups, with_masks);
+}
+
+template<uint32_t N>
+void to_text(const std::string& in, std::ostream& out){
+    catalog<N> c(in);
+    std::vector<uint64_t> data;
+    std::vector<uint32_t> groups;
+    for(size_t i = 0; i < c.size(); i++){
+        data.push_back(c[i].get_data());
+        if(c.has_groups()) groups.push_back(c.group(i));
+    }
+    write_text_catalog(out, N, data, groups);
+}
+
+int main(int argc, char** argv){
+    if(argc < 4){
+        std::cerr << "usage: " << argv[0] << " to-binary <in.txt> <out.bin> [--masks]\n"
+                  << "       " << argv[0] << " to-text <in.bin> <out.txt>\n"
+                  << "A catalog keeps only the matrices and their group ids (idx:). to-text is lossy: labels, the\n"
+                  << "minimal:/all: trailers of min_normal_forms*.txt and the step labels of *_reduction_step.txt are\n"
+                  << "not restored (the reductions stay, as matrices in the group of their idx:)." << std::endl;
+        return 2;
+    }
+    std::string mode = argv[1], in = argv[2], out = argv[3];
+    try {
+        if(mode == "to-binary"){
+            std::ifstream text(in);
+            if(!text) throw std::runtime_error("cannot open " + in);
+            uint32_t n;
+            std::vector<uint64_t> data;
+            std::vector<uint32_t> groups;
+            read_text_catalog(text, n, data, groups);
+            if(data.empty()) throw std::runtime_error("no matrices in " + in);
+            bool with_masks = argc > 4 && std::string(argv[4]) == "--masks";
+            catalog_dispatch(n, [&](auto size){ to_binary<size()>(out, data, groups, with_masks); });
+            std::cerr << data.size() << " matrices " << n << "x" << n << std::endl;
+        } else if(mode == "to-text"){
+            std::ofstream text(out);
+            if(!text) throw std::runtime_error("cannot open " + out);
+            catalog_dispatch(read_catalog_header(in).n, [&](auto size){ to_text<size()>(in, text); });
+        } else {
+            std::cerr << "unknown mode " << mode << std::endl;
+            return 2;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -4,15 +4,28 @@
 #include "debug.hpp"
 #include "compare.hpp"
 #include "matrix_permutations.hpp"
+#include "thread_pool.hpp"
+#include "key_set.hpp"
+#include "minimal_store.hpp"
+#include "matrix_cache.hpp"
+#include "profile.hpp"
 #include <bits/stdc++.h>
 #include <stdint.h>
-#include <set>
 
 template<uint32_t N>
 struct ord_mat_generator{
     uint8_t rows[N];
     uint8_t rows_indep[N];
+    uint32_t fixed = 0; // rows[0..fixed-1] are never advanced
+    bool valid = true;
     ord_mat_generator() { for(int i = 0; i < N; i++) rows[i] = rows_indep[i] = 1<<i; }
+    ord_mat_generator(const uint8_t* prefix, uint32_t _fixed) : fixed(_fixed) {
+        for(uint32_t i = 0; i < fixed; i++) {
+            rows[i] = prefix[i];
+            rows_indep[i] = check(rows[i], i);
+        }
+        valid = fill(fixed);
+    }
     
     uint8_t check(uint8_t x, int n){
         int mask = x;
@@ -26,10 +39,10 @@ struct ord_mat_generator{
     }
 
     bool nxt(int i = N - 1){
-        rows[i]++;
-        while (rows[i] != (1<<N) && !(rows_indep[i] = check(rows[i], i))) ++rows[i];
-        if(rows[i] == (1<<N)) rows[i] = 0;
-        if(rows[i] == 0 && i == 0) return false;
+        uint32_t x = rows[i] + 1; // rows[i] + 1 overflows uint8_t for N = 8
+        while (x != (1U<<N) && !(rows_indep[i] = check(x, i))) ++x;
+        rows[i] = x == (1U<<N) ? 0 : x;
+        if(rows[i] == 0 && i == (int)fixed) return false;
         if(rows[i] == 0){
             if(!nxt(i-1)) return false;
             rows[i] = rows[i-1];
@@ -38,69 +51,453 @@ struct ord_mat_generator{
         return true;
     }
 
+    // first valid completion of rows[i..N-1]
+    bool fill(uint32_t i){
+        if(i == N) return true;
+        for(uint32_t x = (i ? rows[i-1] + 1 : 1); x < (1U<<N); x++){
+            if(!(rows_indep[i] = check(x, i))) continue;
+            rows[i] = x;
+            if(fill(i + 1)) return true;
+        }
+        return false;
+    }
+
+    // calls f(rows) for every valid assignment of rows[0..depth-1], in generation order
+    template<typename F>
+    void for_each_prefix(uint32_t depth, F f, uint32_t i = 0){
+        if(i >= depth || i >= N) { f((const uint8_t*)rows); return; }
+        for(uint32_t x = (i ? rows[i-1] + 1 : 1); x < (1U<<N); x++){
+            if(!(rows_indep[i] = check(x, i))) continue;
+            rows[i] = x;
+            for_each_prefix(depth, f, i + 1);
+        }
+    }
+
     SmallBinaryMatrix<N> get_mat(){
         SmallBinaryMatrix<N> res;
         for(int i = 0; i < N; i++) res[i] = rows[i];
         return res;
     }
-};
 
-const int N = 4;
-using mat = SmallBinaryMatrix<N>;
-using mat_perm = permutation_data<N>;
-
-int main(){
-
-    ord_mat_generator<N> gen;
-    std::set<uint64_t> checked;
-    std::vector<std::pair<mat_perm, mat>> minimals;
-    do {
-        mat m = gen.get_mat();
-        uint64_t key = get_normal_form(m).get_data();
-        
-        if(checked.count(key)) continue;
-        checked.insert(key);
-
-        bool is_min = true;
-        mat_perm cur_mp = get_permutation_data<N>(m);
-
-        for(auto [mp, _] : minimals) {
-            if(mp <= cur_mp) {
-                is_min = false;
-                break;
-            }
-        }
-        if(is_min){
-            for(int i = (int)minimals.size() - 1; i >= 0; i--){ // deleting smaller elements
-                if(cur_mp <= minimals[i].first) {
-                    minimals.erase(minimals.begin() + i);
+    // The one matrix the generator produces for m's class, as a function of m alone (pass the
+    // normal form). The generated matrices are those with increasing rows where the first i rows
+    // cover columns 0..k. Sorting the rows and relabeling the columns by first appearance gives
+    // such a matrix once the relabeling is the identity; until then every round makes the sorted
+    // rows lexicographically smaller, so the loop ends.
+    static SmallBinaryMatrix<N> class_member(SmallBinaryMatrix<N> m){
+        uint8_t r[N];
+        for(uint32_t i = 0; i < N; i++) r[i] = m[i];
+        while(true){
+            std::sort(r, r + N);
+            uint8_t label[N];
+            uint32_t seen = 0, next = 0;
+            bool identity = true;
+            for(uint32_t i = 0; i < N; i++){
+                for(uint32_t x = r[i] & ~seen; x; x &= x - 1){
+                    uint32_t c = __builtin_ctz(x);
+                    identity &= c == next;
+                    label[c] = next++;
                 }
+                seen |= r[i];
+            }
+            if(identity) break;
+            for(uint32_t i = 0; i < N; i++){
+                uint8_t y = 0;
+                for(uint32_t x = r[i]; x; x &= x - 1) y |= 1U << label[__builtin_ctz(x)];
+                r[i] = y;
             }
-            minimals.emplace_back(cur_mp, m);
         }
+        SmallBinaryMatrix<N> res;
+        for(uint32_t i = 0; i < N; i++) res[i] = r[i];
+        return res;
+    }
+};
 
-    } while(gen.nxt());
+// Walks the last row of the generator's matrices for a fixed prefix rows[0..N-2]. Every step
+// flips single entries of the last row and updates the minor table and the reduction of the row
+// against the prefix with them, so nothing is recomputed per matrix. In counting order a step
+// flips two entries on average and the matrices come in the order of ord_mat_generator; in
+// Gray-code order (gray) a step flips exactly one.
+template<uint32_t N>
+struct last_row_walker{
+    SmallBinaryMatrix<N> m;
+    minor_table<N> minors;
 
-    std::cout << "1. ordering count: " << minimals.size() << std::endl;
+    last_row_walker(const uint8_t* prefix) : m(prefix_mat(prefix)), minors(m) {
+        uint8_t indep[N];
+        for(uint32_t i = 0; i + 1 < N; i++){
+            uint8_t x = prefix[i];
+            for(uint32_t k = 0; k < i; k++) if((x>>__builtin_ctz(indep[k]))&1) x ^= indep[k];
+            indep[i] = x;
+            prefix_mask |= prefix[i];
+        }
+        for(uint32_t b = 0; b < N; b++){
+            uint8_t x = 1U<<b;
+            for(uint32_t k = 0; k + 1 < N; k++) if((x>>__builtin_ctz(indep[k]))&1) x ^= indep[k];
+            reduced_unit[b] = x;
+        }
+        lowest = N > 1 ? prefix[N - 2] + 1 : 1;
+    }
 
-    for(int i = (int)minimals.size() - 1; i >= 0; i--){
-        int j = 0;
-        while(j < (int)minimals.size() && (j == i || !check_prec2(minimals[j].second, minimals[i].second))) ++j;
-        if(j < (int)minimals.size()) {
-            minimals.erase(minimals.begin() + i);
+    // calls f() for every valid last row, with m and minors describing the current matrix
+    template<typename F>
+    void for_each(bool gray, F f) {
+        for(uint32_t k = 0; k < (1U<<N); k++){
+            uint32_t x = gray ? k ^ (k >> 1) : k;
+            for(uint32_t diff = x ^ row; diff; diff &= diff - 1) flip(__builtin_ctz(diff));
+            if(x >= lowest && reduced && __builtin_popcount((prefix_mask | x) + 1) == 1) f();
         }
     }
-    
-    std::cout << "2. ordering count: " << minimals.size() << std::endl;
-    
-    for(int i = (int)minimals.size() - 1; i >= 0; i--){
-        int j = 0;
-        while(j < (int)minimals.size() && (j == i || !check_prec1(minimals[j].second, minimals[i].second))) ++j;
-        if(j < (int)minimals.size()) {
-            minimals.erase(minimals.begin() + i);
+
+private:
+    uint32_t row = 0, reduced = 0; // last row, and what is left of it after the reduction
+    uint32_t prefix_mask = 0, lowest = 1;
+    uint8_t reduced_unit[N];
+
+    static SmallBinaryMatrix<N> prefix_mat(const uint8_t* prefix) {
+        SmallBinaryMatrix<N> res;
+        for(uint32_t i = 0; i + 1 < N; i++) res[i] = prefix[i];
+        return res;
+    }
+
+    void flip(uint32_t c) {
+        m[N - 1][c] = !m[N - 1][c];
+        minors.flip(N - 1, c);
+        row ^= 1U<<c;
+        reduced ^= reduced_unit[c];
+    }
+};
+
+// Orderly generation of the nonsingular matrices, one per class under row and column
+// permutations: the canonical form (get_normal_form) of each class, built from its most
+// significant row down. The top k rows of a canonical form are a canonical k-row block, so a block
+// is only extended while it is its own canonical_labelling, and every canonical block is reached
+// from its unique parent exactly once. Rows dependent on the ones above are never placed.
+template<uint32_t N>
+struct orderly_generator{
+    uint8_t rows[N]; // rows[0] is the most significant one, the row N-1 of the matrix
+    uint8_t rows_indep[N];
+
+    // calls f(rows) for every canonical block of depth rows that extends rows[0..k-1], in decreasing order
+    template<typename F>
+    void for_each_block(uint32_t depth, F f, uint32_t k = 0){
+        if(k == depth || k == N) { f((const uint8_t*)rows); return; }
+        for(uint32_t x = (k ? rows[k-1] : 1U<<N) - 1; x > 0; x--){
+            uint8_t y = x;
+            for(uint32_t i = 0; i < k; i++) if((y>>__builtin_ctz(rows_indep[i]))&1) y ^= rows_indep[i];
+            if(!y) continue;
+            rows[k] = x;
+            rows_indep[k] = y;
+            if(!std::equal(rows, rows + k + 1, canonical_labelling<N>(rows, k + 1).run())) continue;
+            for_each_block(depth, f, k + 1);
+        }
+    }
+
+    // for_each_block from a block of depth rows produced by it
+    template<typename F>
+    void for_each_completion(const uint8_t* prefix, uint32_t depth, F f){
+        for(uint32_t k = 0; k < depth; k++){
+            uint8_t y = rows[k] = prefix[k];
+            for(uint32_t i = 0; i < k; i++) if((y>>__builtin_ctz(rows_indep[i]))&1) y ^= rows_indep[i];
+            rows_indep[k] = y;
+        }
+        for_each_block(N, f, depth);
+    }
+
+    static SmallBinaryMatrix<N> get_mat(const uint8_t* rows){
+        SmallBinaryMatrix<N> res;
+        for(uint32_t i = 0; i < N; i++) res[N - 1 - i] = rows[i];
+        return res;
+    }
+};
+
+template<uint32_t N>
+using minimal_list = std::vector<std::pair<permutation_data<N>, SmallBinaryMatrix<N>>>;
+template<uint32_t N>
+using minimal_set = minimal_store<N, SmallBinaryMatrix<N>>;
+
+template<uint32_t N>
+struct shard_result{
+    minimal_list<N> minimals;
+    uint64_t classes = 0; // classes of matrices counted by this shard
+    size_t set_memory = 0; // bytes of the shard's set of seen normal forms
+};
+
+// minimal elements of one subtree of the generator. A class is counted by the shard that holds
+// its ord_mat_generator::class_member, so the shard counts add up without a shared set. With
+// cached, permutation data comes from matrix_cache (and is kept there for later runs).
+template<uint32_t N>
+shard_result<N> run_shard(const uint8_t* prefix, uint32_t depth, bool gray, bool cached){
+    minimal_set<N> minimals;
+    uint64_t classes = 0;
+    ord_mat_generator<N> gen(prefix, depth);
+    if(!gen.valid) return {};
+    flat_key_set checked;
+    gen.for_each_prefix(N - 1, [&](const uint8_t* rows) {
+        last_row_walker<N> walker(rows);
+        walker.for_each(gray, [&]() {
+            SmallBinaryMatrix<N> nf = get_normal_form(walker.m);
+            uint64_t key = get_data(nf);
+            classes += ord_mat_generator<N>::class_member(nf) == walker.m;
+            if(!checked.insert(key)) return;
+            if(cached) minimals.insert(matrix_cache<N>::get().find_normal_form(nf)->permutations(), walker.m);
+            else minimals.insert(get_permutation_data<N>(walker.minors), walker.m);
+        });
+    }, depth);
+    return {minimals.items(), classes, checked.memory_usage()};
+}
+
+// the same for a subtree of orderly_generator, where every matrix is a new class
+template<uint32_t N>
+shard_result<N> run_orderly_shard(const uint8_t* prefix, uint32_t depth, bool cached){
+    minimal_set<N> minimals;
+    uint64_t classes = 0;
+    orderly_generator<N>().for_each_completion(prefix, depth, [&](const uint8_t* rows) {
+        SmallBinaryMatrix<N> m = orderly_generator<N>::get_mat(rows); // a normal form
+        classes++;
+        if(cached) minimals.insert(matrix_cache<N>::get().find_normal_form(m)->permutations(), m);
+        else minimals.insert(get_permutation_data<N>(m), m);
+    });
+    return {minimals.items(), classes, 0};
+}
+
+// How the matrices are enumerated. The shards and the representatives depend on it, so a
+// checkpoint only resumes a run with the same mode.
+enum class walk_mode : uint32_t { counting, orderly, gray };
+
+const char* walk_mode_name(walk_mode mode){
+    switch(mode){
+        case walk_mode::orderly: return "--orderly";
+        case walk_mode::gray: return "--gray";
+        default: return "neither --gray nor --orderly";
+    }
+}
+
+// State of enumerate_minimals after the first next_shard shards were merged. Matrices are stored
+// as raw words, their permutation data is recomputed on load.
+struct checkpoint{
+    uint32_t depth = 0; // prefix length of the shards, 0 if nothing was saved
+    walk_mode mode = walk_mode::counting;
+    uint64_t next_shard = 0;
+    uint64_t classes = 0; // classes of matrices in the merged shards
+    std::vector<uint64_t> minimals;
+};
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x33434d42; // "BMC3"
+
+template<typename T>
+void write_words(std::ofstream& out, const std::vector<T>& v){
+    uint64_t cnt = v.size();
+    out.write(reinterpret_cast<const char*>(&cnt), sizeof(cnt));
+    out.write(reinterpret_cast<const char*>(v.data()), cnt * sizeof(T));
+}
+
+template<typename T>
+bool read_words(std::ifstream& in, std::vector<T>& v){
+    uint64_t cnt = 0;
+    if(!in.read(reinterpret_cast<char*>(&cnt), sizeof(cnt))) return false;
+    v.resize(cnt);
+    return (bool)in.read(reinterpret_cast<char*>(v.data()), cnt * sizeof(T));
+}
+
+// written to path.tmp and renamed, so an interrupted write keeps the previous checkpoint
+template<uint32_t N>
+void save_checkpoint(const std::string& path, const checkpoint& cp){
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        const uint32_t header[4] = {CHECKPOINT_MAGIC, (uint32_t)N, cp.depth, (uint32_t)cp.mode};
+        const uint64_t position[2] = {cp.next_shard, cp.classes};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(position), sizeof(position));
+        write_words(out, cp.minimals);
+        if(!out.flush()) throw std::runtime_error("cannot write checkpoint " + tmp);
+    }
+    if(std::rename(tmp.c_str(), path.c_str()) != 0) throw std::runtime_error("cannot rename checkpoint to " + path);
+}
+
+template<uint32_t N>
+checkpoint load_checkpoint(const std::string& path){
+    checkpoint cp;
+    std::ifstream in(path, std::ios::binary);
+    if(!in) throw std::runtime_error("cannot open " + path);
+    uint32_t header[4];
+    uint64_t position[2];
+    if(!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != CHECKPOINT_MAGIC || header[1] != (uint32_t)N)
+        throw std::runtime_error("not a checkpoint for N = " + std::to_string(N) + ": " + path);
+    cp.depth = header[2];
+    if(header[3] > (uint32_t)walk_mode::gray) throw std::runtime_error("unknown enumeration mode in checkpoint " + path);
+    cp.mode = (walk_mode)header[3];
+    if(!in.read(reinterpret_cast<char*>(position), sizeof(position)) || !read_words(in, cp.minimals))
+        throw std::runtime_error("truncated checkpoint " + path);
+    cp.next_shard = position[0];
+    cp.classes = position[1];
+    return cp;
+}
+
+struct options{
+    uint32_t n = 4;
+    uint32_t threads = std::thread::hardware_concurrency();
+    std::string checkpoint_path; // empty: no checkpoints
+    uint32_t checkpoint_interval = 60; // seconds
+    bool resume = false;
+    bool gray = false; // last rows in Gray-code order instead of increasing order
+    bool orderly = false; // orderly_generator instead of ord_mat_generator
+    std::string cache_path; // matrix_cache file, loaded before and saved after the run
+    size_t cache_size = 1 << 16; // entries
+    bool profile_threads = false; // per-thread stages in the profile (-DENABLE_PROFILE builds)
+};
+
+// Splits the generator by its first rows. Shards are merged in generation order, so the result is
+// the same as a single-threaded pass: the first seen element of every minimal group survives.
+// With a checkpoint path the merged state is saved every checkpoint_interval seconds, and a
+// resumed run only submits the shards that were not merged yet. Orderly runs split
+// orderly_generator the same way. The number of classes is added up in classes, set_memory is the
+// largest set of seen normal forms a shard of this run kept.
+template<uint32_t N>
+minimal_list<N> enumerate_minimals(thread_pool& pool, uint64_t& classes, size_t& set_memory, const options& opt){
+    checkpoint cp;
+    if(opt.resume) cp = load_checkpoint<N>(opt.checkpoint_path);
+    const walk_mode mode = opt.orderly ? walk_mode::orderly : (opt.gray ? walk_mode::gray : walk_mode::counting);
+    if(opt.resume && cp.mode != mode) throw std::runtime_error(std::string("the checkpoint was written with ") + walk_mode_name(cp.mode) + ", this run uses " + walk_mode_name(mode));
+
+    uint32_t depth = cp.depth ? cp.depth : 1;
+    std::vector<std::array<uint8_t, N>> prefixes;
+    while(true){
+        prefixes.clear();
+        auto add_prefix = [&](const uint8_t* rows) {
+            prefixes.emplace_back();
+            std::copy(rows, rows + depth, prefixes.back().begin());
+        };
+        if(opt.orderly) orderly_generator<N>().for_each_block(depth, add_prefix);
+        else ord_mat_generator<N>().for_each_prefix(depth, add_prefix);
+        if(cp.depth || depth + 1 >= N || prefixes.size() >= 16 * pool.size()) break;
+        depth++;
+    }
+
+    minimal_set<N> minimals;
+    for(uint64_t data : cp.minimals) minimals.insert(get_permutation_data<N>(SmallBinaryMatrix<N>(data)), SmallBinaryMatrix<N>(data));
+    classes = cp.classes;
+    if(opt.resume) std::cerr << "resumed at shard " << cp.next_shard << "/" << prefixes.size() << std::endl;
+
+    std::vector<std::future<shard_result<N>>> results;
+    for(size_t i = cp.next_shard; i < prefixes.size(); i++){
+        auto& prefix = prefixes[i];
+        auto task = std::make_shared<std::packaged_task<shard_result<N>()>>([&prefix, depth, &opt] {
+            const bool cached = !opt.cache_path.empty();
+            return opt.orderly ? run_orderly_shard<N>(prefix.data(), depth, cached) : run_shard<N>(prefix.data(), depth, opt.gray, cached);
+        });
+        results.push_back(task->get_future());
+        pool.submit([task] { (*task)(); });
+    }
+
+    const uint64_t first_shard = cp.next_shard;
+    auto last_save = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < results.size(); i++){
+        shard_result<N> res = results[i].get();
+        for(auto& [mp, m] : res.minimals) minimals.insert(std::move(mp), m);
+        classes += res.classes;
+        set_memory = std::max(set_memory, res.set_memory);
+        if(opt.checkpoint_path.empty()) continue;
+        auto now = std::chrono::steady_clock::now();
+        if(i + 1 < results.size() && now - last_save < std::chrono::seconds(opt.checkpoint_interval)) continue;
+        cp.depth = depth;
+        cp.mode = mode;
+        cp.next_shard = first_shard + i + 1;
+        cp.classes = classes;
+        cp.minimals.clear();
+        for(auto& [mp, m] : minimals.items()) cp.minimals.push_back(m.get_data());
+        save_checkpoint<N>(opt.checkpoint_path, cp);
+        std::cerr << "checkpoint: shard " << cp.next_shard << "/" << prefixes.size() << ", " << minimals.size() << " minimal" << std::endl;
+        last_save = now;
+    }
+    return minimals.items();
+}
+
+// Removes, going from the last element to the first, every element preceded by another remaining
+// one. Element i is removed iff some j < i precedes it (those are all still there when i is
+// visited) or some j > i that survives precedes it. The pairs are checked in parallel: first
+// j < i, up to the first hit, then j > i for the elements left, into one dominance bitmap row
+// per element; the removals are then replayed from the bitmap in the serial order. prec gets the
+// matrix_info of both matrices, so what it derives from one matrix is shared by all its pairs.
+template<uint32_t N, typename F>
+minimal_list<N> reduce(thread_pool& pool, const minimal_list<N>& minimals, F prec){
+    const size_t n = minimals.size(), words = (n + 63) / 64;
+    std::vector<char> removed(n, 0);
+    std::vector<std::vector<uint64_t>> dominated_by(n);
+    std::vector<std::shared_ptr<const matrix_info<N>>> info(n);
+
+    for(size_t i = 0; i < n; i++) pool.submit([&, i] { info[i] = matrix_cache<N>::get().find(minimals[i].second); });
+    pool.wait();
+    for(size_t i = 0; i < n; i++){
+        pool.submit([&, i] {
+            for(size_t j = 0; j < i && !removed[i]; j++) removed[i] = prec(*info[j], *info[i]);
+        });
+    }
+    pool.wait();
+    for(size_t i = 0; i < n; i++){
+        if(removed[i]) continue;
+        pool.submit([&, i] {
+            dominated_by[i].assign(words, 0);
+            for(size_t j = i + 1; j < n; j++){
+                if(!removed[j] && prec(*info[j], *info[i])) dominated_by[i][j / 64] |= 1ULL << (j % 64);
+            }
+        });
+    }
+    pool.wait();
+
+    std::vector<uint64_t> alive(words, 0);
+    for(size_t i = n; i-- > 0;){
+        if(removed[i]) continue;
+        bool dominated = false;
+        for(size_t w = 0; w < words; w++) dominated |= (dominated_by[i][w] & alive[w]) != 0;
+        if(!dominated) alive[i / 64] |= 1ULL << (i % 64);
+    }
+    minimal_list<N> res;
+    for(size_t i = 0; i < n; i++) if((alive[i / 64] >> (i % 64)) & 1) res.push_back(minimals[i]);
+    return res;
+}
+
+template<uint32_t N>
+int run(options opt){
+    using info = matrix_info<N>;
+    if(opt.resume && opt.checkpoint_path.empty()) opt.checkpoint_path = "checkpoint" + std::to_string(N) + ".bin";
+    thread_pool pool(opt.threads);
+    auto& cache = matrix_cache<N>::get();
+    cache.set_capacity(opt.cache_size);
+
+    uint64_t classes = 0;
+    size_t set_memory = 0;
+    minimal_list<N> minimals;
+    try {
+        if(!opt.cache_path.empty() && cache.load(opt.cache_path)) std::cerr << "cache: loaded " << cache.size() << " entries" << std::endl;
+        PROFILE_SCOPE(enumerate);
+        minimals = enumerate_minimals<N>(pool, classes, set_memory, opt);
+        if(!opt.cache_path.empty()){
+            if(!cache.save(opt.cache_path))
+                std::cerr << "cache: --cache-size " << opt.cache_size << " is too small (" << cache.dropped() << " entries dropped), " << opt.cache_path << " was not saved" << std::endl;
+            std::cerr << "cache: " << cache.hits() << " hits, " << cache.misses() << " misses" << std::endl;
         }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "normal forms: " << classes;
+    if(!opt.orderly) std::cerr << " (largest shard set " << (set_memory + 1023) / 1024 << " KiB)";
+    std::cerr << std::endl;
+
+    std::cout << "1. ordering count: " << minimals.size() << std::endl;
+
+    {
+        PROFILE_SCOPE(reduce2);
+        minimals = reduce<N>(pool, minimals, [](const info& m1, const info& m2) { return check_prec2(m1, m2); });
     }
+    std::cout << "2. ordering count: " << minimals.size() << std::endl;
 
+    {
+        PROFILE_SCOPE(reduce1);
+        minimals = reduce<N>(pool, minimals, [](const info& m1, const info& m2) { return check_prec1(m1, m2); });
+    }
     std::cout << "3. ordering count: " << minimals.size() << std::endl;
 
     for(int i = 0; i < (int)minimals.size(); i++){
@@ -109,5 +506,66 @@ int main(){
         std::cout << '\n';
     }
 
+    PROFILE_REPORT(std::cerr, opt.profile_threads);
     return 0;
-}
\ No newline at end of file
+}
+
+constexpr const char* USAGE =
+    "usage: check_orderings [-n N] [-j threads] [--gray | --orderly] [--checkpoint file] [--checkpoint-interval seconds]\n"
+    "                       [--resume] [--cache file] [--cache-size entries] [--profile-threads]";
+
+constexpr uint32_t MAX_THREADS = 4096; // -j; thread_pool starts every thread up front
+
+// the value of option, a whole decimal number in [lo, hi]
+uint64_t parse_number(const std::string& option, const std::string& value, uint64_t lo, uint64_t hi){
+    size_t end = 0;
+    uint64_t res = 0;
+    try {
+        if(!value.empty() && std::isdigit((unsigned char)value[0])) res = std::stoull(value, &end);
+    } catch(const std::out_of_range&) {
+        res = UINT64_MAX, end = value.size();
+    }
+    if(end == 0 || end != value.size()) throw std::invalid_argument(option + " needs a whole number, got \"" + value + "\"");
+    if(res < lo) throw std::invalid_argument(option + " must be at least " + std::to_string(lo) + ", got " + value);
+    if(res > hi) throw std::invalid_argument(option + " must be at most " + std::to_string(hi) + ", got " + value);
+    return res;
+}
+
+// every size is compiled in, -n picks one at runtime
+int main(int argc, char** argv){
+    options opt;
+    try {
+        for(int i = 1; i < argc; i++){
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if(i + 1 == argc) throw std::invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            if(arg == "--resume") opt.resume = true;
+            else if(arg == "--gray") opt.gray = true;
+            else if(arg == "--orderly") opt.orderly = true;
+            else if(arg == "--profile-threads") opt.profile_threads = true;
+            else if(arg == "-n") opt.n = parse_number(arg, value(), 2, 8); // the sizes run() is compiled for
+            else if(arg == "-j") opt.threads = parse_number(arg, value(), 1, MAX_THREADS);
+            else if(arg == "--checkpoint") opt.checkpoint_path = value();
+            else if(arg == "--checkpoint-interval") opt.checkpoint_interval = parse_number(arg, value(), 0, UINT32_MAX);
+            else if(arg == "--cache") opt.cache_path = value();
+            else if(arg == "--cache-size") opt.cache_size = parse_number(arg, value(), 0, SIZE_MAX);
+            else throw std::invalid_argument("unknown argument " + arg);
+        }
+        if(opt.gray && opt.orderly) throw std::invalid_argument("--gray and --orderly cannot be combined");
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << '\n' << USAGE << std::endl;
+        return 2;
+    }
+    switch(opt.n){
+        case 2: return run<2>(opt);
+        case 3: return run<3>(opt);
+        case 4: return run<4>(opt);
+        case 5: return run<5>(opt);
+        case 6: return run<6>(opt);
+        case 7: return run<7>(opt);
+        case 8: return run<8>(opt);
+    }
+    return 2;
+}
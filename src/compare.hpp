@@ -2,65 +2,52 @@
 
 #include <cstdint>
 #include <functional>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <bit>
+#include <vector>
 #include "binary_matrix.hpp"
+#include "minor_table.hpp"
+#include "permutation_tables.hpp"
+#include "profile.hpp"
 
-template<uint32_t N, uint32_t K>
-bool _check_prec_exact1(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2){
-    
-    if(m1.get_data() == m2.get_data()) return false;
-
-    if constexpr (K <= 1) {
-        return (m2.get_data() & m1.get_data()) == m1.get_data();
-    } else {
-        if(!_check_prec_exact1<N, K-1>(m1, m2)) return false;
-        for(auto rows : subset_mask<N, K>) {
-            for(auto cols : subset_mask<N, K>) {
-                auto m12 = m1.template sub_matrix<K>(rows, cols);
-                auto m22 = m2.template sub_matrix<K>(rows, cols);
-                if(!m12.singular() && m22.singular()) return false;
-            }
-        }
-        return true;
-    }
+// m1 precedes m2 if every nonsingular minor of size 1..N-1 of m1 is nonsingular in m2 (and m1 != m2).
+// Masks hold the minors of size 1..N-1 (minor_table::mask<N - 1>()).
+template<uint32_t N>
+bool check_prec_exact1(const minor_mask<N>& m1, const minor_mask<N>& m2){
+    constexpr uint32_t entries = sub_matrix_cnt<N, 1>(); // the 1-minors are the entries of the matrix
+    if(((m1 ^ m2) << (m1.size() - entries)).none()) return false;
+    return (m1 & ~m2).none();
 }
 
+// as above, but only for the minors of m1 whose complementary minor is nonsingular as well
 template<uint32_t N>
-bool check_prec_exact1(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2){
-    return _check_prec_exact1<N, N-1>(m1, m2); 
+bool check_prec_exact2(const minor_mask<N>& m1, const minor_mask<N>& m1_complement, const minor_mask<N>& m2){
+    return (m1 & m1_complement & ~m2).none();
 }
 
-template<uint32_t N, uint32_t K>
-bool _check_prec_exact2(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2){
-    if constexpr (K > 1) {
-        if(!_check_prec_exact2<N, K-1>(m1, m2)) return false;
-    } 
-    for(auto rows : subset_mask<N, K>) {
-        for(auto cols : subset_mask<N, K>) {
-            auto m12 = m1.template sub_matrix<K>(rows, cols);
-            auto m22 = m2.template sub_matrix<K>(rows, cols);
-     
-            const auto mask_inv = (1<<N) - 1;
-            auto m_comp = m1.template sub_matrix<N - K>(mask_inv ^ rows, mask_inv ^ cols);
-            if(!m_comp.singular() && (!m12.singular() && m22.singular())) return false;
-        }
-    }
-    return true;
+template<uint32_t N>
+bool check_prec_exact1(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2){
+    return check_prec_exact1<N>(minor_table<N>(m1).template mask<N - 1>(), minor_table<N>(m2).template mask<N - 1>());
 }
 
 template<uint32_t N>
 bool check_prec_exact2(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2){
-    return _check_prec_exact2<N, N-1>(m1, m2);
+    minor_table<N> minors(m1);
+    return check_prec_exact2<N>(minors.template mask<N - 1>(), minors.template complement_mask<N - 1>(), minor_table<N>(m2).template mask<N - 1>());
 }
 
-template<uint32_t N>
-bool check_prec(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2, std::function<bool(SmallBinaryMatrix<N>, SmallBinaryMatrix<N>)> comp, SmallBinaryMatrix<N>* out_prec = nullptr) {
+// brute force over all reorderings; Matrix is SmallBinaryMatrix or BinaryMatrix
+template<uint32_t N, template<uint32_t> class Matrix>
+bool check_prec(Matrix<N> m1, Matrix<N> m2, std::type_identity_t<std::function<bool(Matrix<N>, Matrix<N>)>> comp, Matrix<N>* out_prec = nullptr) {
     uint32_t row_ord[N], col_ord[N];
     for(uint32_t i = 0; i < N; i++) row_ord[i] = i;
     do {
         for(uint32_t i = 0; i < N; i++) col_ord[i] = i;
         do {
-            SmallBinaryMatrix<N> tmp1 = m1;
-            SmallBinaryMatrix<N> tmp2 = m1;
+            Matrix<N> tmp1 = m1;
+            Matrix<N> tmp2 = m1;
             
             tmp1.reorder_rows(row_ord);
             tmp1.reorder_cols(col_ord);
@@ -83,12 +70,242 @@ bool check_prec(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2, std::function<
     return false;
 }
 
+// Reorderings (a, b) with m2[a[i]][b[j]] == m2[i][j] map every reordering of m1 that precedes m2
+// to another one, (row_ord, col_ord) -> (row_ord o a, col_ord o b). The search only needs the
+// lexicographically smallest ordering of each such orbit; it satisfies row_ord[i] < row_ord[j] for
+// every j in the orbit of i under the automorphisms fixing 0..i-1 (col_ord likewise, for the
+// automorphisms with a = id). allowed_rows/allowed_cols flag the orders passing these tests.
+template<uint32_t N>
+struct automorphism_filter{
+    std::vector<bool> allowed_rows, allowed_cols;
+
+    automorphism_filter(SmallBinaryMatrix<N> m2) {
+        const auto& tables = permutation_tables<N>::get();
+        SmallBinaryMatrix<N> m2_t = m2;
+        m2_t.transpose();
+        std::array<uint8_t, N> cols2 = sorted_rows(m2_t);
+
+        std::vector<std::array<uint32_t, N>> row_auts, col_auts;
+        for(const auto& ord : tables.perms){
+            SmallBinaryMatrix<N> tmp = m2;
+            tmp.reorder_rows(ord.data());
+            tmp.transpose();
+            if(sorted_rows(tmp) == cols2) row_auts.push_back(ord); // some column order completes it
+            tmp = m2;
+            tmp.reorder_cols(ord.data());
+            if(tmp == m2) col_auts.push_back(ord);
+        }
+        allowed_rows = allowed(row_auts);
+        allowed_cols = allowed(col_auts);
+    }
+
+private:
+    static std::array<uint8_t, N> sorted_rows(SmallBinaryMatrix<N> m) {
+        std::array<uint8_t, N> res;
+        for(uint32_t i = 0; i < N; i++) res[i] = m[i];
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+
+    static std::vector<bool> allowed(const std::vector<std::array<uint32_t, N>>& auts) {
+        std::vector<std::pair<uint32_t, uint32_t>> less; // ord[i] < ord[j] is required
+        for(uint32_t i = 0; i < N; i++){
+            uint32_t orbit = 0;
+            for(const auto& a : auts){
+                bool fixes = true;
+                for(uint32_t k = 0; k < i; k++) fixes &= a[k] == k;
+                if(fixes) orbit |= 1U<<a[i];
+            }
+            for(uint32_t j = i + 1; j < N; j++) if((orbit>>j)&1) less.emplace_back(i, j);
+        }
+        const auto& tables = permutation_tables<N>::get();
+        std::vector<bool> res;
+        for(const auto& ord : tables.perms){
+            bool ok = true;
+            for(auto [i, j] : less) ok &= ord[i] < ord[j];
+            res.push_back(ok);
+        }
+        return res;
+    }
+};
+
+// Permutation-invariant summary of a set of (rows, cols) minors of a matrix: the number of minors of
+// each size k (16-bit lane k-1 of cnt, the 1-minors counting the ones) and the sorted row and column
+// weights of the 1-minors (byte i, ascending). If a reordering of m1 has its required minors among
+// the nonsingular minors of m2, every lane of the signature of the required minors is at most the
+// one of m2, so the check is a few SWAR subtractions.
+template<uint32_t N>
+struct prec_signature{
+    std::array<uint64_t, 2> cnt{};
+    uint64_t rows = 0, cols = 0;
+
+    prec_signature() = default;
+
+    explicit prec_signature(const std::vector<std::pair<uint8_t, uint8_t>>& minors) {
+        SmallBinaryMatrix<N> entries;
+        for(auto [r, c] : minors) {
+            add(std::popcount(r), 1);
+            if(std::popcount(r) == 1) entries[__builtin_ctz(r)][__builtin_ctz(c)] = 1;
+        }
+        set_weights(entries);
+    }
+
+    // all nonsingular minors of m
+    prec_signature(SmallBinaryMatrix<N> m, const minor_table<N>& minors) {
+        for(uint32_t r = 1; r < (1U<<N); r++) add(std::popcount(r), minors.det[r].count());
+        set_weights(m);
+    }
+
+    uint32_t ones() const { return cnt[0] & 0xFFFF; }
+
+    // 0 if no reordering of the minors of s1 can lie within those of s2, else bit 0 (m1 as it is)
+    // and bit 1 (m1 transposed) tell which orientations remain
+    static uint32_t orientations(const prec_signature& s1, const prec_signature& s2) {
+        if(!dominated(s1.cnt[0], s2.cnt[0], H16) || !dominated(s1.cnt[1], s2.cnt[1], H16)) return 0;
+        return (dominated(s1.rows, s2.rows, H8) && dominated(s1.cols, s2.cols, H8))
+            | (dominated(s1.cols, s2.rows, H8) && dominated(s1.rows, s2.cols, H8)) << 1;
+    }
+
+private:
+    static constexpr uint64_t H8 = 0x8080808080808080, H16 = 0x8000800080008000;
+
+    // every lane of a is at most the one of b; lanes stay below their top bit
+    static bool dominated(uint64_t a, uint64_t b, uint64_t h) { return (((b | h) - a) & h) == h; }
+
+    void add(uint32_t k, uint64_t n) { cnt[(k - 1) / 4] += n << (16 * ((k - 1) % 4)); }
+
+    void set_weights(SmallBinaryMatrix<N> m) {
+        rows = packed_weights(m);
+        m.transpose();
+        cols = packed_weights(m);
+    }
+
+    static uint64_t packed_weights(SmallBinaryMatrix<N> m) {
+        std::array<uint8_t, N> w;
+        for(uint32_t i = 0; i < N; i++) w[i] = std::popcount((uint8_t)m[i]);
+        std::sort(w.begin(), w.end());
+        uint64_t res = 0;
+        for(uint32_t i = 0; i < N; i++) res |= (uint64_t)w[i] << (8 * i);
+        return res;
+    }
+};
+
+// What check_prec_minors needs of m2. It depends on m2 alone, so a caller comparing one matrix with
+// many others builds it once (matrix_cache keeps one per normal form). The automorphism filter is
+// only built by the first search that gets past the signature.
+template<uint32_t N>
+struct prec_target{
+    SmallBinaryMatrix<N> m;
+    minor_table<N> minors;
+    prec_signature<N> signature;
+
+    explicit prec_target(SmallBinaryMatrix<N> m2) : m(m2), minors(m2), signature(m2, minors) {}
+
+    const automorphism_filter<N>& filter() const {
+        std::call_once(filter_once, [this]() { filter_data.emplace(m); });
+        return *filter_data;
+    }
+
+private:
+    mutable std::once_flag filter_once;
+    mutable std::optional<automorphism_filter<N>> filter_data;
+};
+
+// the minors check_prec1 (all proper ones) and check_prec2 (those with a nonsingular complement)
+// require of m1, smallest first
+template<uint32_t N>
+std::vector<std::pair<uint8_t, uint8_t>> proper_minors(const minor_table<N>& minors1) {
+    std::vector<std::pair<uint8_t, uint8_t>> res;
+    minors1.for_each_proper_minor([&](uint32_t rows, uint32_t cols) { res.emplace_back(rows, cols); });
+    return res;
+}
+
+template<uint32_t N>
+std::vector<std::pair<uint8_t, uint8_t>> complemented_minors(const minor_table<N>& minors1) {
+    const uint32_t inv = (1U<<N) - 1;
+    std::vector<std::pair<uint8_t, uint8_t>> res;
+    minors1.for_each_proper_minor([&](uint32_t rows, uint32_t cols) {
+        if(minors1.nonsingular(rows ^ inv, cols ^ inv)) res.emplace_back(rows, cols);
+    });
+    return res;
+}
+
+// Same search as check_prec, on minors: some reordering of m1 (or of its transpose) must have a
+// nonsingular minor in m2 wherever m1 has one of the `required` (rows, cols) minors. Minors are
+// moved through permutation_tables instead of reordering m1, and a reordering is dropped at the
+// first missing minor, so required should list small minors first. The search only starts if the
+// signature of the required minors fits into the one of m2, and orderings equivalent under an
+// automorphism of m2 are skipped.
+template<uint32_t N>
+bool check_prec_minors(SmallBinaryMatrix<N> m1, const std::vector<std::pair<uint8_t, uint8_t>>& required, const prec_signature<N>& required_signature, const prec_target<N>& target, SmallBinaryMatrix<N>* out_prec = nullptr) {
+    const minor_table<N>& minors2 = target.minors;
+
+    PROFILE_COUNT(prec_searches);
+    const uint32_t orientations = prec_signature<N>::orientations(required_signature, target.signature);
+    if(!orientations) { PROFILE_COUNT(signature_rejects); return false; }
+    const bool try_plain = orientations & 1, try_transposed = orientations & 2;
+
+    const automorphism_filter<N>& filter = target.filter();
+    const auto& tables = permutation_tables<N>::get();
+    const uint32_t perm_cnt = tables.perms.size();
+    [[maybe_unused]] uint64_t tried = 0;
+    for(uint32_t p = 0; p < perm_cnt; p++){
+        if(!filter.allowed_rows[p]) continue;
+        const auto& row_img = tables.preimage[p];
+        for(uint32_t q = 0; q < perm_cnt; q++){
+            if(!filter.allowed_cols[q]) continue;
+            const auto& col_img = tables.preimage[q];
+            for(uint32_t transposed = 0; transposed < 2; transposed++){
+                if(!(transposed ? try_transposed : try_plain)) continue;
+                tried++;
+                bool ok = true;
+                for(auto [rows, cols] : required){
+                    if(transposed) std::swap(rows, cols);
+                    if(!minors2.nonsingular(row_img[rows], col_img[cols])) { ok = false; break; }
+                }
+                if(!ok) continue;
+                PROFILE_HISTOGRAM(prec_orderings, tried);
+                if(out_prec){
+                    *out_prec = m1;
+                    if(transposed) out_prec->transpose();
+                    out_prec->permute(tables.perms[p].data(), tables.perms[q].data());
+                }
+                return true;
+            }
+        }
+    }
+    PROFILE_HISTOGRAM(prec_orderings_failed, tried);
+    return false;
+}
+
+template<uint32_t N>
+bool check_prec_minors(SmallBinaryMatrix<N> m1, const std::vector<std::pair<uint8_t, uint8_t>>& required, SmallBinaryMatrix<N> m2, SmallBinaryMatrix<N>* out_prec = nullptr) {
+    return check_prec_minors(m1, required, prec_signature<N>(required), prec_target<N>(m2), out_prec);
+}
+
+// the 1-minors are the entries: a reordered m1 must be a proper subset of m2
+template<uint32_t N>
+bool check_prec1(SmallBinaryMatrix<N> m1, const std::vector<std::pair<uint8_t, uint8_t>>& proper1, const prec_signature<N>& signature1, const prec_target<N>& target, SmallBinaryMatrix<N>* out_prec = nullptr) {
+    PROFILE_SCOPE(check_prec1);
+    if(signature1.ones() >= target.signature.ones()) return false;
+    return check_prec_minors(m1, proper1, signature1, target, out_prec);
+}
+
 template<uint32_t N>
 bool check_prec1(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2, SmallBinaryMatrix<N>* out_prec = nullptr) {
-    return check_prec<N>(m1, m2, check_prec_exact1<N>, out_prec);
+    PROFILE_SCOPE(check_prec1);
+    if(std::popcount(m1.get_data()) >= std::popcount(m2.get_data())) return false;
+    return check_prec_minors(m1, proper_minors(minor_table<N>(m1)), m2, out_prec);
+}
+
+template<uint32_t N>
+bool check_prec2(SmallBinaryMatrix<N> m1, const std::vector<std::pair<uint8_t, uint8_t>>& complemented1, const prec_signature<N>& signature1, const prec_target<N>& target, SmallBinaryMatrix<N>* out_prec = nullptr) {
+    PROFILE_SCOPE(check_prec2);
+    return check_prec_minors(m1, complemented1, signature1, target, out_prec);
 }
 
 template<uint32_t N>
 bool check_prec2(SmallBinaryMatrix<N> m1, SmallBinaryMatrix<N> m2, SmallBinaryMatrix<N>* out_prec = nullptr) {
-    return check_prec<N>(m1, m2, check_prec_exact2<N>, out_prec);
-}
\ No newline at end of file
+    PROFILE_SCOPE(check_prec2);
+    return check_prec_minors(m1, complemented_minors(minor_table<N>(m1)), m2, out_prec);
+}
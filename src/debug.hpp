@@ -1,10 +1,11 @@
 #pragma once
 #include "binary_matrix.hpp"
+#include "wide_binary_matrix.hpp"
 #include "utils.hpp"
 #include <iostream>
 
-template<uint32_t N>
-void print(SmallBinaryMatrix<N> m){
+template<uint32_t N, template<uint32_t> class Matrix>
+void print(Matrix<N> m){
     for(int i = 0; i < N; i++){
         for(int j = 0; j < N; j++) {
             std::cout << m[i][j];
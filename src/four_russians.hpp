@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include "wide_binary_matrix.hpp"
+
+// Method of the Four Russians on the packed rows of BinaryMatrix: K rows are combined into a table
+// of all 2^K xor-combinations (one xor per entry), then every row picks its combination with one
+// lookup on a K-bit chunk instead of up to K separate xors. K around log2(N) balances the two.
+
+template<uint32_t N>
+constexpr uint32_t four_russians_k() { return N <= 16 ? 4 : (N <= 32 ? 5 : 6); }
+
+// a * b (M4RM): the rows of b are taken K at a time, row i of a picks the xor of those selected by
+// bits c..c+K-1
+template<uint32_t N, uint32_t K = four_russians_k<N>()>
+BinaryMatrix<N> m4rm_product(const BinaryMatrix<N>& a, const BinaryMatrix<N>& b) {
+    using row_t = typename BinaryMatrix<N>::row_t;
+    row_t res[N] = {};
+    std::array<row_t, (1U << K)> table;
+    for(uint32_t c = 0; c < N; c += K){
+        const uint32_t k = std::min(K, N - c);
+        table[0] = 0;
+        for(uint32_t g = 1; g < (1U << k); g++) table[g] = table[g & (g - 1)] ^ b.row(c + std::countr_zero(g));
+        for(uint32_t i = 0; i < N; i++) res[i] ^= table[(a.row(i) >> c) & ((1U << k) - 1)];
+    }
+    return BinaryMatrix<N>(res);
+}
+
+// PLU factorization: m with its rows reordered by row_ord is L * U, L unit lower triangular.
+template<uint32_t N>
+struct plu_factors{
+    std::array<uint32_t, N> row_ord;
+    BinaryMatrix<N> L, U;
+};
+
+// Blocked elimination (PLE in the style of M4RI), K columns at a time. The K pivots of a block are
+// found and reduced one by one; candidates are tested on a reduced copy, so the rows below are not
+// touched. The rows below the block are then cleared with one lookup each: the xor of pivots that
+// zeroes a chunk, and the multipliers (the L entries) of that xor, both tabulated by the chunk.
+// The pivot of column i is the first row with a one there after the previous steps, as in
+// reorder_principal_minors_non_singular; without PIVOTING row i must have it (LU_decomposition).
+template<uint32_t N, bool PIVOTING = true, uint32_t K = four_russians_k<N>()>
+plu_factors<N> plu_decomposition(const BinaryMatrix<N>& m) {
+    using row_t = typename BinaryMatrix<N>::row_t;
+    assert(PIVOTING ? !m.singular() : m.main_minors_non_singular());
+    row_t u[N], l[N] = {};
+    plu_factors<N> res;
+    for(uint32_t i = 0; i < N; i++) { u[i] = m.row(i); res.row_ord[i] = i; }
+
+    std::array<row_t, (1U << K)> combo, table;
+    std::array<uint32_t, (1U << K)> multipliers;
+    for(uint32_t c = 0; c < N; c += K){
+        const uint32_t k = std::min(K, N - c);
+        const row_t chunk = (row_t)((1U << k) - 1);
+        for(uint32_t j = 0; j < k; j++){
+            const uint32_t i = c + j;
+            uint32_t r = i, mult = 0;
+            row_t x = 0;
+            for(; r < N; r++){
+                x = u[r], mult = 0;
+                for(uint32_t t = 0; t < j; t++){
+                    if((x >> (c + t)) & 1) { x ^= u[c + t]; mult |= 1U << t; }
+                }
+                if(((x >> i) & 1) || !PIVOTING) break;
+            }
+            assert(r < N && ((x >> i) & 1));
+            std::swap(u[i], u[r]);
+            std::swap(l[i], l[r]);
+            std::swap(res.row_ord[i], res.row_ord[r]);
+            u[i] = x;
+            l[i] |= (row_t)mult << c;
+        }
+
+        combo[0] = 0;
+        table[0] = 0;
+        multipliers[0] = 0;
+        for(uint32_t g = 1; g < (1U << k); g++){
+            combo[g] = combo[g & (g - 1)] ^ u[c + std::countr_zero(g)];
+            uint32_t w = (combo[g] >> c) & chunk;
+            table[w] = combo[g];
+            multipliers[w] = g;
+        }
+        for(uint32_t r = c + k; r < N; r++){
+            uint32_t w = (u[r] >> c) & chunk;
+            u[r] ^= table[w];
+            l[r] |= (row_t)multipliers[w] << c;
+        }
+    }
+    for(uint32_t i = 0; i < N; i++) l[i] |= (row_t)1 << i;
+    res.L = BinaryMatrix<N>(l);
+    res.U = BinaryMatrix<N>(u);
+    return res;
+}
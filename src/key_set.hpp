@@ -0,0 +1,64 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+inline uint64_t hash_key(uint64_t x) { // splitmix64 finalizer
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Open-addressing set of 64-bit keys with linear probing. 0 marks an empty slot, so the key 0 is
+// stored aside.
+class flat_key_set{
+public:
+    explicit flat_key_set(size_t capacity = 16) {
+        size_t cap = 16;
+        while(cap < 2 * capacity) cap *= 2;
+        slots.assign(cap, 0);
+    }
+
+    bool insert(uint64_t key) { // true if the key was not present
+        if(key == 0) {
+            bool res = !has_zero;
+            has_zero = true;
+            return res;
+        }
+        if(2 * (cnt + 1) > slots.size()) grow();
+        size_t i = find_slot(key);
+        if(slots[i] == key) return false;
+        slots[i] = key;
+        cnt++;
+        return true;
+    }
+
+    bool contains(uint64_t key) const {
+        return key == 0 ? has_zero : slots[find_slot(key)] == key;
+    }
+
+    size_t size() const { return cnt + has_zero; }
+    size_t memory_usage() const { return sizeof(*this) + slots.size() * sizeof(uint64_t); } // bytes
+
+    template<typename F>
+    void for_each(F f) const {
+        if(has_zero) f(0ULL);
+        for(uint64_t key : slots) if(key) f(key);
+    }
+
+private:
+    std::vector<uint64_t> slots;
+    size_t cnt = 0;
+    bool has_zero = false;
+
+    size_t find_slot(uint64_t key) const {
+        size_t mask = slots.size() - 1, i = hash_key(key) & mask;
+        while(slots[i] != 0 && slots[i] != key) i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        std::vector<uint64_t> old(slots.size() * 2, 0);
+        old.swap(slots);
+        for(uint64_t key : old) if(key) slots[find_slot(key)] = key;
+    }
+};
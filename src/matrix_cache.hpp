@@ -0,0 +1,224 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "binary_matrix.hpp"
+#include "matrix_operations.hpp"
+#include "compare.hpp"
+#include "matrix_permutations.hpp"
+
+// What the enumeration derives from one class of matrices, computed for its normal form m. Every
+// part is built by its first user. check_prec1/check_prec2 do not change when either matrix is
+// reordered, and permutation data only changes by a translation, so the parts of the normal form
+// stand in for those of every matrix of the class.
+template<uint32_t N>
+class matrix_info{
+public:
+    explicit matrix_info(SmallBinaryMatrix<N> normal_form) : m(normal_form) {}
+
+    SmallBinaryMatrix<N> matrix() const { return m; }
+
+    const permutation_data<N>& permutations() const {
+        std::call_once(permutations_once, [this]() {
+            permutations_data = get_permutation_data<N>(target().minors);
+            permutations_set.store(true, std::memory_order_release);
+        });
+        return permutations_data;
+    }
+    bool has_permutations() const { return permutations_set.load(std::memory_order_acquire); }
+
+    // minor table, signature of the nonsingular minors, automorphism filter
+    const prec_target<N>& target() const {
+        std::call_once(target_once, [this]() { target_data.emplace(m); });
+        return *target_data;
+    }
+
+    // the minors check_prec1 and check_prec2 require when m is the first argument, and their signatures
+    const std::vector<std::pair<uint8_t, uint8_t>>& proper() const {
+        std::call_once(proper_once, [this]() {
+            proper_data = proper_minors(target().minors);
+            proper_sig = prec_signature<N>(proper_data);
+        });
+        return proper_data;
+    }
+    const prec_signature<N>& proper_signature() const { proper(); return proper_sig; }
+
+    const std::vector<std::pair<uint8_t, uint8_t>>& complemented() const {
+        std::call_once(complemented_once, [this]() {
+            complemented_data = complemented_minors(target().minors);
+            complemented_sig = prec_signature<N>(complemented_data);
+        });
+        return complemented_data;
+    }
+    const prec_signature<N>& complemented_signature() const { complemented(); return complemented_sig; }
+
+    void set_permutations(permutation_data<N> pd) { // data read from a cache file
+        std::call_once(permutations_once, [&]() {
+            permutations_data = std::move(pd);
+            permutations_set.store(true, std::memory_order_release);
+        });
+    }
+
+private:
+    SmallBinaryMatrix<N> m;
+    mutable std::once_flag permutations_once, target_once, proper_once, complemented_once;
+    mutable permutation_data<N> permutations_data;
+    mutable std::atomic<bool> permutations_set{false};
+    mutable std::optional<prec_target<N>> target_data;
+    mutable std::vector<std::pair<uint8_t, uint8_t>> proper_data, complemented_data;
+    mutable prec_signature<N> proper_sig, complemented_sig;
+};
+
+template<uint32_t N>
+bool check_prec1(const matrix_info<N>& m1, const matrix_info<N>& m2) {
+    return check_prec1(m1.matrix(), m1.proper(), m1.proper_signature(), m2.target());
+}
+
+template<uint32_t N>
+bool check_prec2(const matrix_info<N>& m1, const matrix_info<N>& m2) {
+    return check_prec2(m1.matrix(), m1.complemented(), m1.complemented_signature(), m2.target());
+}
+
+// Process-wide cache of matrix_info keyed by the get_data() of the normal form. Lookups share a
+// read lock; a miss inserts under the write lock. Beyond capacity entries are evicted in CLOCK
+// order (an entry that was looked up since the hand last passed it gets another round), and an
+// evicted entry stays valid for whoever still holds it. The permutation data can be saved to a
+// file and loaded by a later run; once an entry was dropped the cache no longer holds everything
+// the file may have had, so save() leaves the file alone.
+template<uint32_t N>
+class matrix_cache{
+public:
+    static matrix_cache& get() {
+        static matrix_cache cache;
+        return cache;
+    }
+
+    void set_capacity(size_t c) {
+        std::unique_lock lock(mutex);
+        capacity = c;
+        while(nodes.size() > capacity) evict();
+    }
+
+    std::shared_ptr<const matrix_info<N>> find(SmallBinaryMatrix<N> m) { return find_normal_form(get_normal_form(m)); }
+
+    // nf must be a normal form (get_normal_form)
+    std::shared_ptr<const matrix_info<N>> find_normal_form(SmallBinaryMatrix<N> nf) { return lookup(nf); }
+
+    size_t size() const { std::shared_lock lock(mutex); return nodes.size(); }
+    uint64_t hits() const { return hit_cnt.load(); }
+    uint64_t misses() const { return miss_cnt.load(); }
+    uint64_t dropped() const { std::shared_lock lock(mutex); return dropped_cnt; } // evicted, or not kept at capacity 0
+
+    // Cache file: {magic, N}, the entry count, then per entry the normal form, the size of its
+    // permutation data and the data. Only entries with computed permutation data are written.
+    // Returns false, without writing, if entries were dropped: the file would lose them.
+    bool save(const std::string& path) const {
+        const std::string tmp = path + ".tmp";
+        {
+            std::shared_lock lock(mutex);
+            if(dropped_cnt) return false;
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            std::vector<const matrix_info<N>*> saved;
+            for(const auto& [key, n] : nodes) if(n.info->has_permutations()) saved.push_back(n.info.get());
+            const uint32_t header[2] = {MAGIC, (uint32_t)N};
+            const uint64_t cnt = saved.size();
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(&cnt), sizeof(cnt));
+            for(const auto* info : saved){
+                const auto& perms = info->permutations().permutations;
+                const uint64_t entry[2] = {info->matrix().get_data(), perms.size()};
+                out.write(reinterpret_cast<const char*>(entry), sizeof(entry));
+                for(const auto& mp : perms) out.write(reinterpret_cast<const char*>(&mp.code), sizeof(mp.code));
+            }
+            if(!out.flush()) throw std::runtime_error("cannot write cache " + tmp);
+        }
+        if(std::rename(tmp.c_str(), path.c_str()) != 0) throw std::runtime_error("cannot rename cache to " + path);
+        return true;
+    }
+
+    // false if there is no file at path
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if(!in) return false;
+        uint32_t header[2];
+        uint64_t cnt = 0;
+        if(!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != MAGIC || header[1] != (uint32_t)N)
+            throw std::runtime_error("not a cache for N = " + std::to_string(N) + ": " + path);
+        if(!in.read(reinterpret_cast<char*>(&cnt), sizeof(cnt))) throw std::runtime_error("truncated cache " + path);
+        for(uint64_t i = 0; i < cnt; i++){
+            uint64_t entry[2];
+            if(!in.read(reinterpret_cast<char*>(entry), sizeof(entry))) throw std::runtime_error("truncated cache " + path);
+            permutation_data<N> pd;
+            pd.permutations.resize(entry[1]);
+            for(auto& mp : pd.permutations){
+                if(!in.read(reinterpret_cast<char*>(&mp.code), sizeof(mp.code))) throw std::runtime_error("truncated cache " + path);
+            }
+            auto info = std::const_pointer_cast<matrix_info<N>>(lookup(SmallBinaryMatrix<N>(entry[0]), false));
+            info->set_permutations(std::move(pd));
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x50434d42; // "BMCP"
+
+    struct node{
+        std::shared_ptr<matrix_info<N>> info;
+        std::atomic<bool> referenced{true};
+        explicit node(std::shared_ptr<matrix_info<N>> i) : info(std::move(i)) {}
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<uint64_t, node> nodes;
+    std::vector<uint64_t> ring; // keys in CLOCK order
+    size_t hand = 0;
+    size_t capacity = 1 << 16;
+    uint64_t dropped_cnt = 0; // under the write lock
+    std::atomic<uint64_t> hit_cnt{0}, miss_cnt{0};
+
+    matrix_cache() = default;
+
+    std::shared_ptr<const matrix_info<N>> lookup(SmallBinaryMatrix<N> nf, bool count = true) {
+        const uint64_t key = nf.get_data();
+        {
+            std::shared_lock lock(mutex);
+            auto it = nodes.find(key);
+            if(it != nodes.end()){
+                it->second.referenced.store(true, std::memory_order_relaxed);
+                if(count) hit_cnt++;
+                return it->second.info;
+            }
+        }
+        auto info = std::make_shared<matrix_info<N>>(nf);
+        std::unique_lock lock(mutex);
+        if(count) miss_cnt++;
+        if(capacity == 0) { dropped_cnt++; return info; }
+        auto [it, inserted] = nodes.try_emplace(key, info);
+        if(!inserted) return it->second.info; // inserted by another thread meanwhile
+        ring.push_back(key);
+        while(nodes.size() > capacity) evict();
+        return info;
+    }
+
+    void evict() { // under the write lock
+        while(true){
+            if(hand >= ring.size()) hand = 0;
+            auto& n = nodes.at(ring[hand]);
+            if(!n.referenced.exchange(false, std::memory_order_relaxed)) break;
+            hand++;
+        }
+        nodes.erase(ring[hand]);
+        dropped_cnt++;
+        ring[hand] = ring.back();
+        ring.pop_back();
+    }
+};
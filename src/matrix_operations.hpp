@@ -1,11 +1,25 @@
 #pragma once
 #include "binary_matrix.hpp"
 #include "utils.hpp"
+#include "canonical_form.hpp"
+#include "minor_table.hpp"
+#include "profile.hpp"
 #include <bitset>
 #include <algorithm>
 
 template<uint32_t N>
-SmallBinaryMatrix<N> get_normal_form(SmallBinaryMatrix<N> m){
+SmallBinaryMatrix<N> get_normal_form(SmallBinaryMatrix<N> m, bool with_transpose = false){
+    PROFILE_SCOPE(normal_form);
+    return canonical_form(m, with_transpose);
+}
+
+template<uint32_t N>
+BinaryMatrix<N> get_normal_form(const BinaryMatrix<N>& m, bool with_transpose = false){
+    return canonical_form(m, with_transpose);
+}
+
+template<uint32_t N>
+SmallBinaryMatrix<N> get_normal_form_bruteforce(SmallBinaryMatrix<N> m){ // tries all N! column orders
     uint64_t best = m.get_data();
     uint32_t ord_col[N];
     for(int i = 0; i < N; i++) ord_col[i] = i;
@@ -56,18 +70,5 @@ SmallBinaryMatrix<N> mat_from_data(uint64_t d){
 
 template<uint32_t N, uint32_t K>
 std::bitset<sub_matrix_cnt<N, N>()> get_sub_matrix_mask(SmallBinaryMatrix<N> m){
-    std::bitset<sub_matrix_cnt<N, N>()> res;
-    uint32_t idx = 0;
-    if constexpr (K > 1){
-        res = get_sub_matrix_mask<N, K-1>(m);
-        idx = sub_matrix_cnt<N, K - 1>();
-    }
-    // cout << K << " start: " << idx << '\n';
-    for(uint32_t row_mask : subset_mask<N, K>) {
-        for(uint32_t col_mask : subset_mask<N, K>) {
-            auto sub_mat = m.template sub_matrix<K>(row_mask, col_mask);
-            res[idx++] = !sub_mat.singular();
-        }
-    }
-    return res;
+    return minor_table<N>(m).template mask<K>();
 }
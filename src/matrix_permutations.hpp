@@ -4,29 +4,59 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <bitset>
 #include "binary_matrix.hpp"
+#include "minor_table.hpp"
+#include "profile.hpp"
 
+// A permutation of 0..N-1 packed into 4 bits per element, element 0 in the highest nibble, so
+// that integer order is lexicographic order. Composition and inversion go through the nibbles.
+using packed_permutation = uint32_t;
+
+template<uint32_t N>
+uint32_t _nibble(packed_permutation p, uint32_t i) { return (p >> (4 * (N - 1 - i))) & 15; }
+
+template<uint32_t N>
+packed_permutation _pack(const uint32_t* p) {
+    packed_permutation res = 0;
+    for(uint32_t i = 0; i < N; i++) res |= p[i] << (4 * (N - 1 - i));
+    return res;
+}
+
+template<uint32_t N>
+packed_permutation _inverse(packed_permutation p) {
+    packed_permutation res = 0;
+    for(uint32_t i = 0; i < N; i++) res |= i << (4 * (N - 1 - _nibble<N>(p, i)));
+    return res;
+}
+
+template<uint32_t N>
+packed_permutation _product(packed_permutation p1, packed_permutation p2) { // i -> p2[p1[i]]
+    packed_permutation res = 0;
+    for(uint32_t i = 0; i < N; i++) res |= _nibble<N>(p2, _nibble<N>(p1, i)) << (4 * (N - 1 - i));
+    return res;
+}
+
+// (row_ord, col_ord) in one word: row_ord in the high 4N bits, so the order is the lexicographic
+// order of the pair
 template<uint32_t N>
 struct matrix_permutation{
-    matrix_permutation(const std::array<uint32_t, N>& row, const std::array<uint32_t, N>& col) {
-        std::copy(row.begin(), row.end(), row_ord.begin());
-        std::copy(col.begin(), col.end(), col_ord.begin());
-    }
-    matrix_permutation(uint32_t* row, uint32_t* col) {
-        std::copy(row, row + N, row_ord.begin());
-        std::copy(col, col + N, col_ord.begin());
-    }
-    std::array<uint32_t, N> row_ord;
-    std::array<uint32_t, N> col_ord;
+    static_assert(N <= 8);
+    uint64_t code = 0;
 
-    bool operator<(const matrix_permutation<N>& mp) const {
-        return row_ord != mp.row_ord ? row_ord < mp.row_ord : col_ord < mp.col_ord;
-    }
+    matrix_permutation() = default;
+    matrix_permutation(packed_permutation row, packed_permutation col) : code(((uint64_t)row << (4 * N)) | col) {}
+    matrix_permutation(const std::array<uint32_t, N>& row, const std::array<uint32_t, N>& col) : matrix_permutation(row.data(), col.data()) {}
+    matrix_permutation(const uint32_t* row, const uint32_t* col) : matrix_permutation(_pack<N>(row), _pack<N>(col)) {}
 
-    bool operator==(const matrix_permutation<N>& mp) const {
-        return row_ord == mp.row_ord && col_ord == mp.col_ord;
-    }
-};  
+    packed_permutation rows() const { return code >> (4 * N); }
+    packed_permutation cols() const { return code & ((1ULL << (4 * N)) - 1); }
+    uint32_t row_ord(uint32_t i) const { return _nibble<N>(rows(), i); }
+    uint32_t col_ord(uint32_t i) const { return _nibble<N>(cols(), i); }
+
+    bool operator<(const matrix_permutation<N>& mp) const { return code < mp.code; }
+    bool operator==(const matrix_permutation<N>& mp) const { return code == mp.code; }
+};
 
 template<uint32_t N>
 struct permutation_data{
@@ -34,39 +64,28 @@ struct permutation_data{
 
     void normalize() { sort(permutations.begin(), permutations.end()); }
 
+    // some translation (row_ord, col_ord) -> (row_ord o a, col_ord o b), possibly with rows and
+    // columns swapped, maps every permutation into pd. It must map permutations[0] to an element
+    // mp of pd, which fixes (a, b); every other element is then looked up in pd, up to the first miss.
     bool operator<=(const permutation_data& pd) const { // data must be normalized
+        PROFILE_SCOPE(permutation_order);
         if(permutations.size() > pd.permutations.size()) return false;
 
-        for(auto &mp : pd.permutations){
-            std::array<uint32_t, N> row_trans = prod(inv_permutation(permutations[0].row_ord), mp.row_ord);
-            std::array<uint32_t, N> col_trans = prod(inv_permutation(permutations[0].col_ord), mp.col_ord);
-            std::vector<matrix_permutation<N>> tmp_permutations;
-
-            assert(prod(permutations[0].row_ord, row_trans) == mp.row_ord);
-            assert(prod(permutations[0].col_ord, col_trans) == mp.col_ord);
-
-            for(auto &mp2 : permutations){
-                tmp_permutations.push_back(matrix_permutation<N>(prod(mp2.row_ord, row_trans), prod(mp2.col_ord, col_trans)));
-            }
-            sort(tmp_permutations.begin(), tmp_permutations.end()); // normalize tmp data
-            if(check_subset(tmp_permutations, pd.permutations)) return true;
-        }   
-
-        for(auto &mp : pd.permutations){ // flipped coordinates
-            std::array<uint32_t, N> row_trans = prod(inv_permutation(permutations[0].row_ord), mp.col_ord);
-            std::array<uint32_t, N> col_trans = prod(inv_permutation(permutations[0].col_ord), mp.row_ord);
-            std::vector<matrix_permutation<N>> tmp_permutations;
-
-            assert(prod(permutations[0].row_ord, row_trans) == mp.col_ord);
-            assert(prod(permutations[0].col_ord, col_trans) == mp.row_ord);
-
-            for(auto &mp2 : permutations){
-                tmp_permutations.push_back(matrix_permutation<N>(prod(mp2.col_ord, col_trans), prod(mp2.row_ord, row_trans)));
+        const packed_permutation row_inv = _inverse<N>(permutations[0].rows());
+        const packed_permutation col_inv = _inverse<N>(permutations[0].cols());
+        for(uint32_t flipped = 0; flipped < 2; flipped++){
+            for(auto &mp : pd.permutations){
+                packed_permutation row_trans = _product<N>(row_inv, flipped ? mp.cols() : mp.rows());
+                packed_permutation col_trans = _product<N>(col_inv, flipped ? mp.rows() : mp.cols());
+                bool ok = true;
+                for(size_t i = 1; i < permutations.size() && ok; i++){
+                    packed_permutation rows = _product<N>(permutations[i].rows(), row_trans);
+                    packed_permutation cols = _product<N>(permutations[i].cols(), col_trans);
+                    ok = pd.contains(flipped ? matrix_permutation<N>(cols, rows) : matrix_permutation<N>(rows, cols));
+                }
+                if(ok) return true;
             }
-            sort(tmp_permutations.begin(), tmp_permutations.end()); // normalize tmp data
-            if(check_subset(tmp_permutations, pd.permutations)) return true;
-        }   
-
+        }
         return false;
     }
 
@@ -74,74 +93,127 @@ struct permutation_data{
         auto it = lower_bound(permutations.begin(), permutations.end(), mp);
         return it != permutations.end() && (*it) == mp;
     }
+};
+
+// Depth-first search for get_permutation_data. The leading k x k minor of a reordering only
+// depends on the sets R_k, C_k of the first k rows and columns, the trailing (N-k) x (N-k) minor on
+// their complements, so a reordering is valid iff ok[R_k][C_k] for k = 0..N, where ok[R][C] is
+// det(R, C) != 0 && det(~R, ~C) != 0. Rows are placed one at a time, keeping the set of column
+// prefixes C_k still reachable through valid minors, and a row prefix with none left is pruned.
+// For a complete row order the column orders are then enumerated through the column sets that
+// can still be completed. Both levels go in increasing order, so the output is sorted.
+template<uint32_t N>
+struct _permutation_search{
+    using col_sets = std::bitset<(1<<N)>;
+    static constexpr uint32_t FULL = (1U<<N) - 1;
+
+    std::array<col_sets, (1<<N)> ok;
+    col_sets reachable[N + 1], completable[N + 1];
+    uint32_t row_ord[N], col_ord[N];
+    permutation_data<N>& res;
+
+    _permutation_search(const minor_table<N>& minors, permutation_data<N>& _res) : res(_res) {
+        for(uint32_t rows = 0; rows <= FULL; rows++){
+            const auto& det = minors.det[rows];
+            for(size_t cols = det._Find_first(); cols < det.size(); cols = det._Find_next(cols)){
+                if(minors.nonsingular(rows ^ FULL, cols ^ FULL)) ok[rows][cols] = 1;
+            }
+        }
+        reachable[0] = ok[0] & col_sets(1); // the empty prefix; needs m nonsingular
+        if(reachable[0].any()) place_rows(0, 0);
+    }
 
-private:
-    std::array<uint32_t, N> inv_permutation(const std::array<uint32_t, N>& p) const {
-        std::array<uint32_t, N> res;
-        for(int i = 0; i < N; i++) res[p[i]] = i;
+    static col_sets add_col(const col_sets& c) { // { C + c : C in c, c not in C }
+        col_sets res;
+        for(uint32_t j = 0; j < N; j++) res |= (c & without_col[j]) << (1U<<j);
         return res;
     }
 
-    std::array<uint32_t, N> prod(const std::array<uint32_t, N>& p1, const std::array<uint32_t, N>& p2) const {
-        std::array<uint32_t, N> res;
-        for(int i = 0; i < N; i++) res[i] = p2[p1[i]];
+    static col_sets remove_col(const col_sets& c) { // { C - c : C in c, c in C }
+        col_sets res;
+        for(uint32_t j = 0; j < N; j++) res |= (c & ~without_col[j]) >> (1U<<j);
         return res;
     }
 
-    bool check_subset(const std::vector<matrix_permutation<N>>& p1, const std::vector<matrix_permutation<N>> &p2) const { // !!! data must be normalized
-        // sort(p1.begin(), p1.end());
-        // sort(p2.begin(), p2.end());
-        int j = 0;
-        for(auto &mp : p2) {
-            if(j < (int)p1.size() && p1[j] == mp) j++;
+    void place_rows(uint32_t k, uint32_t rows) {
+        if(k == N){
+            completable[N] = reachable[N];
+            for(uint32_t i = N; i-- > 0;) completable[i] = reachable[i] & remove_col(completable[i + 1]);
+            place_cols(0, 0);
+            return;
+        }
+        const col_sets next = add_col(reachable[k]);
+        for(uint32_t r = 0; r < N; r++){
+            if((rows>>r)&1) continue;
+            reachable[k + 1] = next & ok[rows | (1U<<r)];
+            if(reachable[k + 1].none()) continue;
+            row_ord[k] = r;
+            place_rows(k + 1, rows | (1U<<r));
         }
-        return j == (int)p1.size();
     }
+
+    void place_cols(uint32_t k, uint32_t cols) {
+        if(k == N){
+            res.permutations.push_back(matrix_permutation<N>(row_ord, col_ord));
+            return;
+        }
+        for(uint32_t c = 0; c < N; c++){
+            if(((cols>>c)&1) || !completable[k + 1][cols | (1U<<c)]) continue;
+            col_ord[k] = c;
+            place_cols(k + 1, cols | (1U<<c));
+        }
+    }
+
+    // sets of columns that do not contain c
+    static inline const std::array<col_sets, N> without_col = []() {
+        std::array<col_sets, N> res;
+        for(uint32_t c = 0; c < N; c++){
+            for(uint32_t cols = 0; cols <= FULL; cols++) res[c][cols] = !((cols>>c)&1);
+        }
+        return res;
+    }();
 };
 
+// all (row_ord, col_ord) whose reordering has nonsingular leading and trailing principal minors
 template<uint32_t N>
-permutation_data<N> get_permutation_data(SmallBinaryMatrix<N> m) { // Returns normalized data
-    uint32_t row_ord[N], col_ord[N];
+permutation_data<N> get_permutation_data(const minor_table<N>& minors) { // Returns normalized data
+    PROFILE_SCOPE(permutation_data);
     permutation_data<N> res;
-    for(int i = 0; i < N; i++) row_ord[i] = i;
-    do {
-        for(int i = 0; i < N; i++) col_ord[i] = i;
-        do {
-            SmallBinaryMatrix<N> tmp(m);
-            tmp.reorder_rows(row_ord);
-            tmp.reorder_cols(col_ord);
-            if(tmp.main_minors_non_singular() && tmp.anti_minors_non_singular()) res.permutations.push_back(matrix_permutation<N>(row_ord, col_ord));
-        } while(std::next_permutation(col_ord, col_ord + N));
-    } while(std::next_permutation(row_ord, row_ord + N));
-    sort(res.permutations.begin(), res.permutations.end());
+    _permutation_search<N>(minors, res);
+    PROFILE_HISTOGRAM(permutations, res.permutations.size());
     return res;
 }
 
+template<uint32_t N>
+permutation_data<N> get_permutation_data(SmallBinaryMatrix<N> m) { // Returns normalized data
+    return get_permutation_data<N>(minor_table<N>(m));
+}
+
 template<uint32_t N, uint32_t K>
-SmallBinaryMatrix<N> _reorder(SmallBinaryMatrix<N> m) {
+SmallBinaryMatrix<N> _reorder(SmallBinaryMatrix<N> m, const minor_table<N>& minors, uint32_t* row_ord, uint32_t* col_ord, uint32_t row_mask, uint32_t col_mask) {
+    // row_mask/col_mask: original indices of the first K rows/columns
     const int MASK_INV = (1<<N) - 1;
-    const int mask = (1<<K) - 1;
-    if constexpr (K >= N - 1) {
-        return m;
-    } else{
+    if constexpr (K < N - 1) {
         for(int i = K; i < N; i++){
             for(int j = K; j < N; j++){
-                int row_mask = mask | (1<<i);
-                int col_mask = mask | (1<<j);
-                auto sub_m = m.sub_matrix<K + 1>(row_mask, col_mask);
-                auto sub_m2 = m.sub_matrix<N - K - 1>(row_mask^MASK_INV, col_mask^MASK_INV);
-                if(!sub_m.singular() && !sub_m2.singular()) {
-                    m.swap_rows(K, i);
-                    m.swap_cols(K, j);
-                    return reorder<K + 1>(m);
+                uint32_t rows = row_mask | (1<<row_ord[i]);
+                uint32_t cols = col_mask | (1<<col_ord[j]);
+                if(minors.nonsingular(rows, cols) && minors.nonsingular(rows^MASK_INV, cols^MASK_INV)) {
+                    std::swap(row_ord[K], row_ord[i]);
+                    std::swap(col_ord[K], col_ord[j]);
+                    return _reorder<N, K + 1>(m, minors, row_ord, col_ord, rows, cols);
                 }
             }
         }
     }
+    m.reorder_rows(row_ord);
+    m.reorder_cols(col_ord);
     return m;
 }
 
 template<uint32_t N>
 SmallBinaryMatrix<N> reorder(SmallBinaryMatrix<N> m) {
-    return _reorder<N, 0>(m);
-}
\ No newline at end of file
+    uint32_t row_ord[N], col_ord[N];
+    for(uint32_t i = 0; i < N; i++) row_ord[i] = col_ord[i] = i;
+    return _reorder<N, 0>(m, minor_table<N>(m), row_ord, col_ord, 0, 0);
+}
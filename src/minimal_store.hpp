@@ -0,0 +1,108 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <utility>
+#include <vector>
+#include "matrix_permutations.hpp"
+
+// Invariants of permutation_data that are monotone under operator<=. A translation relabels the
+// values at every position by the same permutation, so the sorted histogram of the values found at
+// a position can only grow; with rows and columns swapped the row and column histograms trade places.
+template<uint32_t N>
+struct permutation_signature{
+    size_t size = 0;
+    std::array<std::array<uint32_t, N>, N> rows{}, cols{}; // rows[i]: sorted counts of the values of row_ord[i]
+
+    permutation_signature() = default;
+    permutation_signature(const permutation_data<N>& pd) : size(pd.permutations.size()) {
+        for(const auto& mp : pd.permutations){
+            for(uint32_t i = 0; i < N; i++){
+                rows[i][mp.row_ord(i)]++;
+                cols[i][mp.col_ord(i)]++;
+            }
+        }
+        for(uint32_t i = 0; i < N; i++){
+            std::sort(rows[i].begin(), rows[i].end());
+            std::sort(cols[i].begin(), cols[i].end());
+        }
+    }
+
+    // false if pd1 <= pd2 is impossible
+    static bool may_precede(const permutation_signature& s1, const permutation_signature& s2) {
+        if(s1.size > s2.size) return false;
+        return (dominated(s1.rows, s2.rows) && dominated(s1.cols, s2.cols))
+            || (dominated(s1.rows, s2.cols) && dominated(s1.cols, s2.rows));
+    }
+
+private:
+    static bool dominated(const std::array<std::array<uint32_t, N>, N>& h1, const std::array<std::array<uint32_t, N>, N>& h2) {
+        for(uint32_t i = 0; i < N; i++){
+            for(uint32_t v = 0; v < N; v++) if(h1[i][v] > h2[i][v]) return false;
+        }
+        return true;
+    }
+};
+
+// Antichain of permutation_data under operator<=, each element with a payload. insert keeps only
+// the minimal elements, of equivalent ones the first inserted, and elements keep their insertion
+// order. Entries are bucketed by size, and operator<= only runs when the signatures allow it;
+// removed entries are tombstoned and compacted once they make up half of the store.
+template<uint32_t N, typename T>
+class minimal_store{
+public:
+    void insert(permutation_data<N> pd, T value) {
+        permutation_signature<N> sig(pd);
+        for(auto it = buckets.begin(); it != buckets.end() && it->first <= sig.size; ++it){
+            for(uint32_t idx : it->second){
+                const entry& e = entries[idx];
+                if(e.alive && permutation_signature<N>::may_precede(e.sig, sig) && e.pd <= pd) return;
+            }
+        }
+        for(auto it = buckets.lower_bound(sig.size); it != buckets.end(); ++it){
+            for(uint32_t idx : it->second){
+                entry& e = entries[idx];
+                if(e.alive && permutation_signature<N>::may_precede(sig, e.sig) && pd <= e.pd){
+                    e.alive = false;
+                    dead++;
+                }
+            }
+        }
+        buckets[sig.size].push_back(entries.size());
+        entries.push_back(entry{std::move(pd), std::move(sig), std::move(value), true});
+        if(2 * dead > entries.size()) compact();
+    }
+
+    size_t size() const { return entries.size() - dead; }
+
+    // the minimal elements with their payloads, in insertion order
+    std::vector<std::pair<permutation_data<N>, T>> items() const {
+        std::vector<std::pair<permutation_data<N>, T>> res;
+        for(const auto& e : entries) if(e.alive) res.emplace_back(e.pd, e.value);
+        return res;
+    }
+
+private:
+    struct entry{
+        permutation_data<N> pd;
+        permutation_signature<N> sig;
+        T value;
+        bool alive;
+    };
+    std::vector<entry> entries;
+    std::map<size_t, std::vector<uint32_t>> buckets; // size of the data -> indices into entries
+    size_t dead = 0;
+
+    void compact() {
+        std::vector<entry> old;
+        old.swap(entries);
+        buckets.clear();
+        for(auto& e : old){
+            if(!e.alive) continue;
+            buckets[e.sig.size].push_back(entries.size());
+            entries.push_back(std::move(e));
+        }
+        dead = 0;
+    }
+};
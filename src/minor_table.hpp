@@ -0,0 +1,116 @@
+#pragma once
+#include <stdint.h>
+#include <array>
+#include <bitset>
+#include "binary_matrix.hpp"
+#include "utils.hpp"
+
+template<uint32_t N>
+using minor_mask = std::bitset<sub_matrix_cnt<N, N>()>;
+
+// Determinants over GF(2) of every square minor of m, indexed by row and column subsets.
+// A K-minor is expanded along its first row into (K-1)-minors of the remaining rows, so the whole
+// table is built with N bitset shifts per row subset.
+template<uint32_t N>
+struct minor_table{
+    std::array<std::bitset<(1<<N)>, (1<<N)> det; // det[rows][cols], the empty minor is 1
+
+    minor_table(SmallBinaryMatrix<N> m) {
+        det[0][0] = 1;
+        for(uint32_t rows = 1; rows < (1U<<N); rows++){
+            uint32_t r = __builtin_ctz(rows);
+            const auto& prev = det[rows & (rows - 1)];
+            uint8_t row = m[r];
+            for(uint32_t c = 0; c < N; c++){
+                if((row>>c)&1) det[rows] ^= (prev & without_col[c]) << (1U<<c);
+            }
+        }
+    }
+
+    bool nonsingular(uint32_t rows, uint32_t cols) const { return det[rows][cols]; }
+
+    // updates the table after the entry (r, c) of m was flipped: det(R, C) changes by the
+    // complementary det(R - r, C - c) for r in R, c in C, and those minors do not contain (r, c)
+    void flip(uint32_t r, uint32_t c) {
+        for(uint32_t rows = 0; rows < (1U<<N); rows++){
+            if(!((rows>>r)&1)) det[rows | (1U<<r)] ^= (det[rows] & without_col[c]) << (1U<<c);
+        }
+    }
+
+    // nonsingularity of the minors of size 1..K, in the order of get_sub_matrix_mask
+    template<uint32_t K = N>
+    minor_mask<N> mask() const {
+        minor_mask<N> res;
+        uint32_t idx = 0;
+        fill_mask<K, false>(res, idx);
+        return res;
+    }
+
+    // same layout, the bit of a minor tells whether its complementary minor is nonsingular
+    template<uint32_t K = N>
+    minor_mask<N> complement_mask() const {
+        minor_mask<N> res;
+        uint32_t idx = 0;
+        fill_mask<K, true>(res, idx);
+        return res;
+    }
+
+    // calls f(rows, cols) for the nonsingular minors of size 1..N-1, smaller ones first
+    template<typename F>
+    void for_each_proper_minor(F f) const {
+        for(uint32_t rows : proper_subsets){
+            for(size_t cols = det[rows]._Find_first(); cols < det[rows].size(); cols = det[rows]._Find_next(cols)) f(rows, (uint32_t)cols);
+        }
+    }
+
+    // every nonsingular minor of size 1..N-1 is nonsingular in t as well; smaller minors are checked first
+    bool proper_minors_covered_by(const minor_table& t) const {
+        for(uint32_t rows : proper_subsets){
+            if((det[rows] & ~t.det[rows]).any()) return false;
+        }
+        return true;
+    }
+
+    // as above, restricted to the minors whose complementary minor is nonsingular here
+    bool proper_minors_covered_by_complement(const minor_table& t) const {
+        const uint32_t inv = (1U<<N) - 1;
+        for(uint32_t rows : proper_subsets){
+            auto rest = det[rows] & ~t.det[rows];
+            for(size_t cols = rest._Find_first(); cols < rest.size(); cols = rest._Find_next(cols)){
+                if(det[rows ^ inv][cols ^ inv]) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    // row subsets of size 1..N-1, ordered by size
+    static inline const std::array<uint32_t, (1<<N) - 2> proper_subsets = []() {
+        std::array<uint32_t, (1<<N) - 2> res;
+        uint32_t idx = 0;
+        for(uint32_t k = 1; k < N; k++){
+            for(uint32_t rows = 0; rows < (1U<<N); rows++) if(__builtin_popcount(rows) == k) res[idx++] = rows;
+        }
+        return res;
+    }();
+
+    // sets of columns that do not contain c
+    static inline const std::array<std::bitset<(1<<N)>, N> without_col = []() {
+        std::array<std::bitset<(1<<N)>, N> res;
+        for(uint32_t c = 0; c < N; c++){
+            for(uint32_t cols = 0; cols < (1U<<N); cols++) res[c][cols] = !((cols>>c)&1);
+        }
+        return res;
+    }();
+
+    template<uint32_t K, bool COMPLEMENT>
+    void fill_mask(minor_mask<N>& res, uint32_t& idx) const {
+        if constexpr (K > 1) fill_mask<K - 1, COMPLEMENT>(res, idx);
+        const uint32_t inv = COMPLEMENT ? (1U<<N) - 1 : 0;
+        for(uint32_t rows : subset_mask<N, K>) {
+            for(uint32_t cols : subset_mask<N, K>) {
+                res[idx++] = det[rows ^ inv][cols ^ inv];
+            }
+        }
+    }
+};
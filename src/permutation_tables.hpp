@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// All permutations of N elements in std::next_permutation order, with the action of each one on
+// subsets. After reorder_rows(perms[p]) the rows in S are found at the positions preimage[p][S],
+// so a minor (rows, cols) of a reordered matrix is looked up without reordering anything.
+template<uint32_t N>
+struct permutation_tables{
+    std::vector<std::array<uint32_t, N>> perms;
+    std::vector<std::array<uint8_t, (1<<N)>> preimage; // preimage[p][S] = { i : perms[p][i] in S }
+
+    static const permutation_tables& get() {
+        static const permutation_tables tables;
+        return tables;
+    }
+
+private:
+    permutation_tables() {
+        std::array<uint32_t, N> ord;
+        for(uint32_t i = 0; i < N; i++) ord[i] = i;
+        do {
+            perms.push_back(ord);
+            std::array<uint8_t, (1<<N)> img;
+            img[0] = 0;
+            uint32_t pos[N];
+            for(uint32_t i = 0; i < N; i++) pos[ord[i]] = i;
+            for(uint32_t s = 1; s < (1U<<N); s++) img[s] = img[s & (s - 1)] | (1U<<pos[__builtin_ctz(s)]);
+            preimage.push_back(img);
+        } while(std::next_permutation(ord.begin(), ord.end()));
+    }
+};
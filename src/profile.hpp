@@ -0,0 +1,162 @@
+#pragma once
+#include <stdint.h>
+
+// Stage timers and histograms for the enumeration pipeline. They are compiled in with
+// -DENABLE_PROFILE, and otherwise every PROFILE_* macro expands to nothing.
+//
+//   PROFILE_SCOPE(stage)           cycles and calls of the enclosing scope (stages nest, times are inclusive)
+//   PROFILE_HISTOGRAM(hist, value) adds value to a histogram with power-of-two buckets
+//   PROFILE_COUNT(counter)         increments an event counter
+//   PROFILE_REPORT(out, threads)   JSON summary, with a per-thread breakdown if threads is true
+//
+// Every thread counts into its own block, the blocks are only summed by the report.
+
+enum class profile_stage : uint32_t {
+    enumerate, reduce2, reduce1,
+    normal_form, permutation_data, permutation_order, check_prec1, check_prec2,
+    count
+};
+
+enum class profile_histogram : uint32_t {
+    permutations,  // permutations.size() of every computed permutation_data
+    prec_orderings,        // orderings a successful check_prec_minors search tried, the hit included
+    prec_orderings_failed, // orderings a check_prec_minors search tried before it gave up
+    count
+};
+
+enum class profile_counter : uint32_t {
+    prec_searches,     // check_prec_minors calls
+    signature_rejects, // of those, rejected by the invariant signature before the search
+    count
+};
+
+#ifdef ENABLE_PROFILE
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <x86intrin.h>
+
+class profiler{
+public:
+    struct block{
+        std::array<uint64_t, (size_t)profile_stage::count> calls{}, cycles{};
+        std::array<std::array<uint64_t, 65>, (size_t)profile_histogram::count> buckets{}; // bucket b: values of bit width b
+        std::array<uint64_t, (size_t)profile_counter::count> counters{};
+    };
+
+    static profiler& get() {
+        static profiler p;
+        return p;
+    }
+
+    static block& local() {
+        thread_local block* b = get().add_block();
+        return *b;
+    }
+
+    void report(std::ostream& out, bool per_thread) {
+        std::lock_guard<std::mutex> lock(mtx);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        const double cycles_per_second = (__rdtsc() - start_cycles) / seconds;
+        block total;
+        for(const auto& b : blocks){
+            for(size_t s = 0; s < total.calls.size(); s++) { total.calls[s] += b->calls[s]; total.cycles[s] += b->cycles[s]; }
+            for(size_t h = 0; h < total.buckets.size(); h++){
+                for(size_t k = 0; k < total.buckets[h].size(); k++) total.buckets[h][k] += b->buckets[h][k];
+            }
+            for(size_t c = 0; c < total.counters.size(); c++) total.counters[c] += b->counters[c];
+        }
+        out << "{\"threads\": " << blocks.size() << ", \"seconds\": " << seconds << ", \"cycles_per_second\": " << cycles_per_second;
+        out << ",\n \"stages\": ";
+        write_stages(out, total, cycles_per_second);
+        out << ",\n \"histograms\": {";
+        for(size_t h = 0; h < total.buckets.size(); h++){
+            out << (h ? ", " : "") << '"' << HISTOGRAM_NAMES[h] << "\": [";
+            bool first = true;
+            for(size_t k = 0; k < total.buckets[h].size(); k++){
+                if(!total.buckets[h][k]) continue;
+                const uint64_t lo = k ? 1ULL << (k - 1) : 0, hi = k ? lo + (lo - 1) : 0;
+                out << (first ? "" : ", ") << "{\"min\": " << lo << ", \"max\": " << hi << ", \"count\": " << total.buckets[h][k] << "}";
+                first = false;
+            }
+            out << "]";
+        }
+        out << "}";
+        out << ",\n \"counters\": {";
+        for(size_t c = 0; c < total.counters.size(); c++) out << (c ? ", " : "") << '"' << COUNTER_NAMES[c] << "\": " << total.counters[c];
+        out << "}";
+        if(per_thread){
+            out << ",\n \"per_thread\": [";
+            for(size_t t = 0; t < blocks.size(); t++){
+                out << (t ? ",\n   " : "\n   ");
+                write_stages(out, *blocks[t], cycles_per_second);
+            }
+            out << "]";
+        }
+        out << "}" << std::endl;
+    }
+
+private:
+    static constexpr const char* STAGE_NAMES[] = {
+        "enumerate", "reduce2", "reduce1",
+        "normal_form", "permutation_data", "permutation_order", "check_prec1", "check_prec2"
+    };
+    static constexpr const char* HISTOGRAM_NAMES[] = { "permutations", "prec_orderings", "prec_orderings_failed" };
+    static constexpr const char* COUNTER_NAMES[] = { "prec_searches", "signature_rejects" };
+
+    std::mutex mtx;
+    std::vector<std::unique_ptr<block>> blocks;
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    const uint64_t start_cycles = __rdtsc();
+
+    block* add_block() {
+        std::lock_guard<std::mutex> lock(mtx);
+        blocks.push_back(std::make_unique<block>());
+        return blocks.back().get();
+    }
+
+    static void write_stages(std::ostream& out, const block& b, double cycles_per_second) {
+        out << "{";
+        for(size_t s = 0; s < b.calls.size(); s++){
+            out << (s ? ", " : "") << '"' << STAGE_NAMES[s] << "\": {\"calls\": " << b.calls[s] << ", \"cycles\": " << b.cycles[s]
+                << ", \"seconds\": " << b.cycles[s] / cycles_per_second << "}";
+        }
+        out << "}";
+    }
+};
+
+class profile_scope{
+public:
+    explicit profile_scope(profile_stage s) : stage((size_t)s), start(__rdtsc()) {}
+    ~profile_scope() {
+        auto& b = profiler::local();
+        b.calls[stage]++;
+        b.cycles[stage] += __rdtsc() - start;
+    }
+
+private:
+    size_t stage;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) profile_scope PROFILE_CONCAT(_profile_scope_, __LINE__)(profile_stage::stage)
+#define PROFILE_HISTOGRAM(hist, value) (profiler::local().buckets[(size_t)profile_histogram::hist][std::bit_width((uint64_t)(value))]++)
+#define PROFILE_COUNT(counter) (profiler::local().counters[(size_t)profile_counter::counter]++)
+#define PROFILE_REPORT(out, threads) profiler::get().report(out, threads)
+
+#else
+
+#define PROFILE_SCOPE(stage) ((void)0)
+#define PROFILE_HISTOGRAM(hist, value) ((void)0)
+#define PROFILE_COUNT(counter) ((void)0)
+#define PROFILE_REPORT(out, threads) ((void)0)
+
+#endif
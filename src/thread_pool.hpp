@@ -0,0 +1,113 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker pops from the back of its own queue and steals from the front
+// of the others when it runs dry. Tasks submitted from a worker go to that worker's queue.
+class thread_pool{
+public:
+    explicit thread_pool(uint32_t thread_cnt = std::thread::hardware_concurrency()) {
+        if(thread_cnt == 0) thread_cnt = 1;
+        queues.reserve(thread_cnt);
+        for(uint32_t i = 0; i < thread_cnt; i++) queues.push_back(std::make_unique<worker_queue>());
+        for(uint32_t i = 0; i < thread_cnt; i++) workers.emplace_back([this, i] { work(i); });
+    }
+
+    ~thread_pool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        for(auto& w : workers) w.join();
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    uint32_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> task) {
+        uint32_t q = current_pool == this ? current_idx : (next_queue++) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[q]->mtx);
+            queues[q]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            queued++;
+            pending++;
+        }
+        cv.notify_one();
+    }
+
+    void wait() { // blocks until every submitted task has finished
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    struct worker_queue{
+        std::mutex mtx;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cv, done_cv;
+    uint64_t queued = 0, pending = 0; // tasks waiting in queues / not finished yet
+    std::atomic<uint32_t> next_queue{0};
+    bool stop = false;
+
+    static inline thread_local thread_pool* current_pool = nullptr;
+    static inline thread_local uint32_t current_idx = 0;
+
+    bool pop(uint32_t idx, std::function<void()>& task) {
+        {
+            std::lock_guard<std::mutex> lock(queues[idx]->mtx);
+            if(!queues[idx]->tasks.empty()){
+                task = std::move(queues[idx]->tasks.back());
+                queues[idx]->tasks.pop_back();
+                return true;
+            }
+        }
+        for(uint32_t k = 1; k < queues.size(); k++){ // steal
+            auto& q = *queues[(idx + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mtx);
+            if(!q.tasks.empty()){
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(uint32_t idx) {
+        current_pool = this;
+        current_idx = idx;
+        std::function<void()> task;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return queued > 0 || stop; });
+                if(queued == 0) return;
+                queued--; // one queued task is reserved for this worker
+            }
+            while(!pop(idx, task)) std::this_thread::yield();
+            task();
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(mtx);
+            if(--pending == 0) done_cv.notify_all();
+        }
+    }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+template<uint32_t N> requires (N <= 64) class BinaryMatrix;
+template<uint32_t N> std::pair<BinaryMatrix<N>, BinaryMatrix<N>> LU_decomposition(const BinaryMatrix<N>& m);
+
+// NxN binary matrix for N up to 64, one machine word per row (column j is bit j of row i).
+// Same surface as SmallBinaryMatrix, which packs the whole matrix into a single word for N <= 8.
+template<uint32_t N>
+requires (N <= 64)
+class BinaryMatrix{
+public:
+    using row_t = std::conditional_t<(N <= 8), uint8_t, std::conditional_t<(N <= 16), uint16_t, std::conditional_t<(N <= 32), uint32_t, uint64_t>>>;
+    constexpr static uint32_t W = 8 * sizeof(row_t);
+    constexpr static row_t ROW_MASK = N == W ? (row_t)~(row_t)0 : (row_t)(((row_t)1 << N) - 1);
+
+    struct CellWrapper{
+        row_t *ptr;
+        uint32_t i;
+        operator bool() const { return ((*ptr)>>i)&1; }
+        CellWrapper& operator=(const CellWrapper& cw) { *this = (bool)cw; return *this; }
+        CellWrapper& operator=(bool val) {
+            if(val != (((*ptr)>>i)&1)) (*ptr) ^= ((row_t)1<<i);
+            return *this;
+        }
+    };
+    struct RowWrapper{
+        row_t *ptr;
+        operator row_t() { return *ptr; }
+        CellWrapper operator[](uint32_t i) { return CellWrapper{ptr, i}; }
+        RowWrapper& operator+=(RowWrapper r) { (*ptr) ^= (*r.ptr); return *this; }
+        RowWrapper& operator=(row_t d) { *ptr = d & ROW_MASK; return *this; }
+        RowWrapper& operator=(const RowWrapper& rw) { return *this = (row_t)rw; }
+    };
+
+    BinaryMatrix() : data{} {}
+    explicit BinaryMatrix(const row_t* rows) { for(uint32_t i = 0; i < N; i++) data[i] = rows[i] & ROW_MASK; }
+
+    RowWrapper operator[](uint32_t i) { return get_row(i); }
+    RowWrapper get_row(uint32_t i) { return RowWrapper{&data[i]}; }
+    row_t row(uint32_t i) const { return data[i]; }
+    const row_t* rows() const { return data.data(); }
+
+    void swap_rows(uint32_t i, uint32_t j) { std::swap(data[i], data[j]); }
+    void swap_cols(uint32_t i, uint32_t j) {
+        for(auto& r : data){
+            row_t t = ((r >> i) ^ (r >> j)) & 1;
+            r ^= (t << i) | (t << j);
+        }
+    }
+
+    void reorder_rows(const uint32_t *ord) {
+        std::array<row_t, N> new_data;
+        for(uint32_t i = 0; i < N; i++) new_data[i] = data[ord[i]];
+        data = new_data;
+    }
+
+    void reorder_cols(const uint32_t *ord) { // columns are rows of the transpose
+        transpose();
+        reorder_rows(ord);
+        transpose();
+    }
+
+    void permute(const uint32_t *row_ord, const uint32_t *col_ord) {
+        reorder_rows(row_ord);
+        reorder_cols(col_ord);
+    }
+
+    void flip_horizontal() { std::reverse(data.begin(), data.end()); }
+    void flip_vertical() { // reverse the bits of every row
+        for(auto& r : data){
+            row_t x = r;
+            for(uint32_t k = std::countr_zero(W) - 1, s = W / 2; s > 0; k--, s /= 2) x = ((x >> s) & BLOCK_MASK[k]) | ((x & BLOCK_MASK[k]) << s);
+            r = x >> (W - N);
+        }
+    }
+
+    void transpose() { // recursive block swap: exchange the off-diagonal blocks of width s, then halve s
+        std::array<row_t, W> a{};
+        std::copy(data.begin(), data.end(), a.begin());
+        for(uint32_t k = std::countr_zero(W) - 1, s = W / 2; s > 0; k--, s /= 2){
+            row_t m = BLOCK_MASK[k];
+            for(uint32_t j = 0; j < W; j += 2 * s){
+                for(uint32_t i = j; i < j + s; i++){
+                    row_t t = ((a[i] >> s) ^ a[i + s]) & m;
+                    a[i] ^= t << s;
+                    a[i + s] ^= t;
+                }
+            }
+        }
+        std::copy(a.begin(), a.begin() + N, data.begin());
+    }
+    void anti_transpose() { flip_horizontal(); transpose(); flip_horizontal(); }
+
+    bool singular() const {
+        BinaryMatrix tmp(*this);
+        for(uint32_t i = 0; i < N; i++){
+            uint32_t r = tmp.first_row_with_one(i, i);
+            if(r == N) return true;
+            tmp.swap_rows(i, r);
+            tmp.eliminate_below(i);
+        }
+        return false;
+    }
+
+    bool main_minors_non_singular() const {
+        BinaryMatrix tmp(*this);
+        for(uint32_t i = 0; i < N; i++){
+            if(!((tmp.data[i] >> i) & 1)) return false;
+            tmp.eliminate_below(i);
+        }
+        return true;
+    }
+
+    bool anti_minors_non_singular() const {
+        BinaryMatrix tmp(*this);
+        tmp.flip_horizontal();
+        tmp.flip_vertical();
+        return tmp.main_minors_non_singular();
+    }
+
+    template<uint32_t M>
+    BinaryMatrix<M> sub_matrix(uint64_t row_mask, uint64_t col_mask) const {
+        assert(std::popcount(row_mask) == M); // must be square submatrix
+        assert(std::popcount(col_mask) == M); // must be square submatrix
+        typename BinaryMatrix<M>::row_t rows[M];
+        uint32_t idx = 0;
+        for(uint32_t i = 0; i < N; i++){
+            if(!((row_mask >> i) & 1)) continue;
+            typename BinaryMatrix<M>::row_t r = 0;
+            uint32_t k = 0;
+            for(uint32_t j = 0; j < N; j++){
+                if((col_mask >> j) & 1) r |= (typename BinaryMatrix<M>::row_t)((data[i] >> j) & 1) << k++;
+            }
+            rows[idx++] = r;
+        }
+        return BinaryMatrix<M>(rows);
+    }
+
+    bool operator==(const BinaryMatrix& m) const { return data == m.data; }
+    // the order of get_data() for SmallBinaryMatrix: the last row is the most significant
+    bool operator<(const BinaryMatrix& m) const {
+        return std::lexicographical_compare(data.rbegin(), data.rend(), m.data.rbegin(), m.data.rend());
+    }
+
+    BinaryMatrix operator*(const BinaryMatrix& m) const { // row i of the product: xor of the rows of m picked by row i
+        BinaryMatrix res;
+        for(uint32_t i = 0; i < N; i++){
+            row_t acc = 0;
+            for(row_t x = data[i]; x; x &= x - 1) acc ^= m.data[std::countr_zero(x)];
+            res.data[i] = acc;
+        }
+        return res;
+    }
+
+    uint32_t first_row_with_one(uint32_t r, uint32_t c) const { // N if there is none
+        while(r < N && !((data[r] >> c) & 1)) r++;
+        return r;
+    }
+
+    friend std::pair<BinaryMatrix, BinaryMatrix> LU_decomposition<>(const BinaryMatrix&);
+
+private:
+    std::array<row_t, N> data;
+
+    // BLOCK_MASK[k]: the bits whose index has bit k clear
+    constexpr static std::array<row_t, 6> BLOCK_MASK = []() {
+        std::array<row_t, 6> res{};
+        for(uint32_t k = 0; k < 6; k++){
+            for(uint32_t b = 0; b < W; b++) if(!((b >> k) & 1)) res[k] |= (row_t)((row_t)1 << b);
+        }
+        return res;
+    }();
+
+    void eliminate_below(uint32_t i) { // clears column i under the pivot data[i]
+        for(uint32_t k = i + 1; k < N; k++) data[k] ^= data[i] & (row_t)-((data[k] >> i) & 1);
+    }
+};
+
+template<uint32_t N>
+BinaryMatrix<N> reorder_principal_minors_non_singular(const BinaryMatrix<N>& m) {
+    assert(!m.singular());
+    uint32_t row_ord[N];
+    for(uint32_t i = 0; i < N; i++) row_ord[i] = i;
+    BinaryMatrix<N> tmp(m);
+    for(uint32_t i = 0; i < N; i++){
+        uint32_t r = tmp.first_row_with_one(i, i);
+        tmp.swap_rows(i, r);
+        std::swap(row_ord[i], row_ord[r]);
+        for(uint32_t k = i + 1; k < N; k++) if(tmp[k][i]) tmp[k] += tmp[i];
+    }
+    BinaryMatrix<N> res(m);
+    res.reorder_rows(row_ord);
+    return res;
+}
+
+// {L, U} with m = L * U, L unit lower triangular and U upper triangular
+template<uint32_t N>
+std::pair<BinaryMatrix<N>, BinaryMatrix<N>> LU_decomposition(const BinaryMatrix<N>& m) {
+    assert(m.main_minors_non_singular());
+    BinaryMatrix<N> tmp(m), res;
+    for(uint32_t i = 0; i < N; i++){
+        for(uint32_t k = i + 1; k < N; k++){
+            if((tmp.data[k] >> i) & 1){
+                res.data[k] |= (typename BinaryMatrix<N>::row_t)1 << i;
+                tmp.data[k] ^= tmp.data[i];
+            }
+        }
+        res[i][i] = 1;
+    }
+    return {res, tmp};
+}
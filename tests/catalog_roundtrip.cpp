@@ -0,0 +1,88 @@
+#include "catalog.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Round trip of every text file in a directory (output/ by default) through a binary catalog and
+// back to text: the matrices and group ids must survive both steps, and the groups must follow
+// the "idx:" headers of the file. Labels and trailers are not part of a catalog and not compared.
+//
+// g++ -std=c++20 -O2 -I src tests/catalog_roundtrip.cpp -o catalog_roundtrip && ./catalog_roundtrip [dir]
+
+// the idx: values in the order of the file, read independently of read_text_catalog
+std::vector<uint32_t> idx_headers(const std::string& path) {
+    std::ifstream in(path);
+    std::vector<uint32_t> res;
+    std::string line;
+    while(std::getline(in, line)){
+        std::istringstream words(line);
+        std::string word;
+        if(words >> word && word == "idx:") res.push_back(std::stoul(line.substr(line.find("idx:") + 4)));
+    }
+    return res;
+}
+
+template<uint32_t N>
+void binary_round_trip(const std::string& bin, const std::vector<uint64_t>& data, const std::vector<uint32_t>& groups, std::vector<uint64_t>& data_out, std::vector<uint32_t>& groups_out) {
+    write_catalog<N>(bin, std::vector<SmallBinaryMatrix<N>>(data.begin(), data.end()), groups, true);
+    catalog<N> c(bin);
+    for(size_t i = 0; i < c.size(); i++){
+        data_out.push_back(c[i].get_data());
+        if(c.has_groups()) groups_out.push_back(c.group(i));
+        if(c.mask(i) != minor_table<N>(c[i]).template mask<N>()) throw std::runtime_error("minor mask " + std::to_string(i) + " differs");
+    }
+}
+
+void check_file(const std::string& path, const std::string& bin) {
+    uint32_t n;
+    std::vector<uint64_t> data, data_bin, data_text;
+    std::vector<uint32_t> groups, groups_bin, groups_text;
+    {
+        std::ifstream text(path);
+        read_text_catalog(text, n, data, groups);
+    }
+    if(data.empty()) return;
+
+    std::vector<uint32_t> headers = idx_headers(path), starts;
+    for(size_t i = 0; i < groups.size(); i++) if(i == 0 || groups[i] != groups[i - 1]) starts.push_back(groups[i]);
+    if(starts != headers) throw std::runtime_error("groups do not follow the idx: headers");
+
+    catalog_dispatch(n, [&](auto size){ binary_round_trip<size()>(bin, data, groups, data_bin, groups_bin); });
+    if(data_bin != data || groups_bin != groups) throw std::runtime_error("binary catalog differs");
+
+    std::stringstream text;
+    write_text_catalog(text, n, data_bin, groups_bin);
+    uint32_t n_text;
+    read_text_catalog(text, n_text, data_text, groups_text);
+    if(n_text != n || data_text != data || groups_text != groups) throw std::runtime_error("text written from the catalog differs");
+}
+
+int main(int argc, char** argv){
+    const std::string dir = argc > 1 ? argv[1] : "output";
+    const std::string bin = (std::filesystem::temp_directory_path() / "catalog_roundtrip.bin").string();
+    int failed = 0, checked = 0;
+    try {
+        for(const auto& entry : std::filesystem::directory_iterator(dir)){
+            if(!entry.is_regular_file() || entry.path().extension() != ".txt") continue;
+            const std::string path = entry.path().string();
+            checked++;
+            try {
+                check_file(path, bin);
+                std::cout << "ok   " << path << '\n';
+            } catch(const std::exception& e) {
+                std::cout << "FAIL " << path << ": " << e.what() << '\n';
+                failed++;
+            }
+        }
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::filesystem::remove(bin);
+    std::cout << checked - failed << " of " << checked << " files ok" << std::endl;
+    return failed || !checked;
+}